@@ -0,0 +1,60 @@
+#include "Arena.h"
+
+void* Arena::allocateSlow(std::size_t size, std::size_t align) {
+	// gli oggetti troppo grandi hanno un chunk tutto per loro, cosi' il
+	// chunk corrente continua a essere usato
+	if (size + align > chunkSize) {
+		Chunk chunk{ std::make_unique<char[]>(size + align), size + align };
+		std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(chunk.memory.get()) + align - 1) & ~(align - 1);
+		sealed.push_back(std::move(chunk));
+		sealedUsed += size;
+		return reinterpret_cast<void*>(p);
+	}
+
+	if (inUse == chunks.size())
+		chunks.push_back(Chunk{ std::make_unique<char[]>(chunkSize), chunkSize });
+	next = chunks[inUse].memory.get();
+	end = next + chunkSize;
+	++inUse;
+	return allocate(size, align);
+}
+
+
+void Arena::reset() {
+	sealed.clear();
+	sealedUsed = 0;
+	inUse = 0;
+	next = end = nullptr;
+}
+
+
+void Arena::splice(Arena& other) {
+	const std::size_t otherUsed = other.bytesUsed();
+	for (std::size_t i = 0; i < other.inUse; ++i)
+		sealed.push_back(std::move(other.chunks[i]));
+	for (Chunk& chunk : other.sealed)
+		sealed.push_back(std::move(chunk));
+	sealedUsed += otherUsed;
+
+	other.chunks.erase(other.chunks.begin(), other.chunks.begin() + other.inUse);
+	other.sealed.clear();
+	other.reset();
+}
+
+
+std::size_t Arena::bytesUsed() const {
+	std::size_t used = sealedUsed;
+	if (inUse > 0)
+		used += (inUse - 1) * chunkSize + (next - chunks[inUse - 1].memory.get());
+	return used;
+}
+
+
+std::size_t Arena::bytesReserved() const {
+	std::size_t reserved = 0;
+	for (const Chunk& chunk : chunks)
+		reserved += chunk.size;
+	for (const Chunk& chunk : sealed)
+		reserved += chunk.size;
+	return reserved;
+}
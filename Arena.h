@@ -0,0 +1,78 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocatore a incremento di puntatore: la memoria viene presa da blocchi
+// grandi (chunk) e gli oggetti vengono disposti uno dopo l'altro, nell'ordine
+// in cui sono creati. Non si libera mai un singolo oggetto e i distruttori
+// non vengono chiamati: si possono creare solo oggetti che non possiedono
+// altre risorse. reset() rende di nuovo disponibili tutti i chunk, che
+// vengono riusati invece di essere restituiti al sistema.
+class Arena {
+
+public:
+	explicit Arena(std::size_t chunkSize = 64 * 1024) : chunkSize{ chunkSize } {}
+	Arena(Arena const&) = delete;
+	Arena& operator=(Arena const&) = delete;
+
+	void* allocate(std::size_t size, std::size_t align) {
+		std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(next) + align - 1) & ~(align - 1);
+		if (p + size <= reinterpret_cast<std::uintptr_t>(end)) {
+			next = reinterpret_cast<char*>(p + size);
+			return reinterpret_cast<void*>(p);
+		}
+		return allocateSlow(size, align);
+	}
+
+	template <typename T, typename... Args>
+	T* create(Args&&... args) {
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// Array non inizializzato di count elementi
+	template <typename T>
+	T* allocateArray(std::size_t count) {
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Tutta la memoria torna disponibile: gli oggetti creati non vanno piu' usati
+	void reset();
+
+	// Acquisisce la memoria di other (gli oggetti restano dove sono), che
+	// resta vuota: i chunk acquisiti non vengono riusati fino a reset()
+	void splice(Arena& other);
+
+	// Byte consumati (compresi gli avanzi in fondo ai chunk gia' pieni)
+	// e byte richiesti al sistema
+	std::size_t bytesUsed() const;
+	std::size_t bytesReserved() const;
+
+private:
+	void* allocateSlow(std::size_t size, std::size_t align);
+
+	struct Chunk {
+		std::unique_ptr<char[]> memory;
+		std::size_t size;
+	};
+
+	// chunk riusabili, di chunkSize byte: i primi inUse sono stati usati
+	std::vector<Chunk> chunks;
+	std::size_t inUse = 0;
+
+	// chunk per oggetti piu' grandi di chunkSize e chunk acquisiti con
+	// splice: liberati da reset()
+	std::vector<Chunk> sealed;
+	std::size_t sealedUsed = 0;
+
+	char* next = nullptr;
+	char* end = nullptr;
+	std::size_t chunkSize;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "AstStats.h"
+
+#include <iomanip>
+#include <vector>
+
+#include "Atoms.h"
+#include "Visitor.h"
+
+namespace {
+
+	const char* const classNames[numOfNodeKinds] = {
+		"Program", "Block", "Type", "VectorType", "Decls", "Decl", "Id", "Stmts",
+		"IntConstant", "BoolConstant", "Arithm", "Unary", "Access",
+		"If", "Else", "While", "Do", "Set", "SetElem", "Break", "Print",
+		"Not", "And", "Or", "Rel"
+	};
+
+	bool isExpression(NodeKind kind) {
+		switch (kind) {
+		case NodeKind::ID: case NodeKind::INT_CONSTANT: case NodeKind::BOOL_CONSTANT:
+		case NodeKind::BIN_OP: case NodeKind::UNARY_OP: case NodeKind::ACCESS:
+		case NodeKind::NOT: case NodeKind::AND: case NodeKind::OR: case NodeKind::REL:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Conta i nodi e tiene la profondita' corrente delle espressioni e dei
+	// blocchi; gli statement dentro un'espressione non esistono, quindi ogni
+	// espressione di uno statement riparte da zero
+	class Collector : public StaticVisitor<Collector> {
+
+	public:
+		explicit Collector(AstStats& s) : stats{ s }, seen(AtomTable::global().size(), 0) {}
+
+		void visit(Node* node) {
+			const NodeKind kind = node->getKind();
+			++stats.counts[static_cast<std::size_t>(kind)];
+			++stats.nodes;
+
+			const bool expression = isExpression(kind);
+			if (expression && ++expressionDepth > stats.maxExpressionDepth)
+				stats.maxExpressionDepth = expressionDepth;
+			if (kind == NodeKind::BLOCK && ++blockNesting > stats.maxBlockNesting)
+				stats.maxBlockNesting = blockNesting;
+
+			StaticVisitor::visit(node);
+
+			if (expression)
+				--expressionDepth;
+			if (kind == NodeKind::BLOCK)
+				--blockNesting;
+		}
+
+		void visitId(Id* id) {
+			char& mark = seen[id->getAtom()];
+			stats.distinctIdentifiers += !mark;
+			mark = 1;
+		}
+
+	private:
+		AstStats& stats;
+		std::vector<char> seen;
+		std::size_t expressionDepth = 0;
+		std::size_t blockNesting = 0;
+	};
+
+}
+
+
+AstStats AstStats::collect(Program* program, const ExpressionManager& manager) {
+	AstStats stats;
+	Collector{ stats }.visit(program);
+	stats.allocatedNodes = manager.nodeCount();
+	stats.bytesUsed = manager.bytesUsed();
+	stats.bytesReserved = manager.bytesReserved();
+	return stats;
+}
+
+
+void AstStats::print(std::ostream& out) const {
+	auto line = [&](const char* name, std::size_t value) {
+		out << std::left << std::setw(40) << name << std::right << std::setw(12) << value << std::endl;
+	};
+	line("nodi nell'albero", nodes);
+	line("nodi allocati", allocatedNodes);
+	line("byte allocati", bytesUsed);
+	line("byte riservati", bytesReserved);
+	if (allocatedNodes > 0)
+		out << std::left << std::setw(40) << "byte per nodo allocato" << std::right << std::setw(12)
+			<< std::fixed << std::setprecision(1) << double(bytesUsed) / allocatedNodes << std::endl;
+	line("profondita' massima delle espressioni", maxExpressionDepth);
+	line("annidamento massimo dei blocchi", maxBlockNesting);
+	line("identificatori distinti", distinctIdentifiers);
+	out << "nodi per tipo:" << std::endl;
+	for (std::size_t k = 0; k < numOfNodeKinds; ++k)
+		if (counts[k] > 0)
+			out << "  " << std::left << std::setw(38) << classNames[k] << std::right << std::setw(12) << counts[k] << std::endl;
+}
+
+
+// Tutti i tipi compaiono sempre, anche con zero nodi, cosi' che le chiavi
+// siano le stesse fra un'esecuzione e l'altra
+void AstStats::printJson(std::ostream& out) const {
+	out << "{\"nodes\": " << nodes
+		<< ", \"allocatedNodes\": " << allocatedNodes
+		<< ", \"bytesUsed\": " << bytesUsed
+		<< ", \"bytesReserved\": " << bytesReserved
+		<< ", \"maxExpressionDepth\": " << maxExpressionDepth
+		<< ", \"maxBlockNesting\": " << maxBlockNesting
+		<< ", \"distinctIdentifiers\": " << distinctIdentifiers
+		<< ", \"nodesByClass\": {";
+	for (std::size_t k = 0; k < numOfNodeKinds; ++k)
+		out << (k ? ", " : "") << '"' << classNames[k] << "\": " << counts[k];
+	out << "}}" << std::endl;
+}
@@ -0,0 +1,33 @@
+#ifndef AST_STATS_H
+#define AST_STATS_H
+
+#include <cstddef>
+#include <ostream>
+
+#include "ExpressionManager.h"
+#include "Node.h"
+
+// Statistiche di forma e di memoria di un AST gia' analizzato (--ast-stats).
+// I conteggi per tipo sono presi visitando l'albero: con --share un nodo
+// condiviso viene contato in ogni punto in cui compare, mentre
+// allocatedNodes e i byte sono quelli effettivamente allocati dal manager.
+struct AstStats {
+	std::size_t counts[numOfNodeKinds] = {};
+	std::size_t nodes = 0;
+	std::size_t allocatedNodes = 0;
+	std::size_t bytesUsed = 0;
+	std::size_t bytesReserved = 0;
+	// una costante ha profondita' 1, il blocco del programma annidamento 1
+	std::size_t maxExpressionDepth = 0;
+	std::size_t maxBlockNesting = 0;
+	std::size_t distinctIdentifiers = 0;
+
+	// Visita tutto il programma (con --lazy anche i blocchi non ancora
+	// analizzati, che vengono analizzati ora)
+	static AstStats collect(Program* program, const ExpressionManager& manager);
+
+	void print(std::ostream& out) const;
+	void printJson(std::ostream& out) const;
+};
+
+#endif
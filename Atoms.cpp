@@ -0,0 +1,82 @@
+#include "Atoms.h"
+
+#include <cstring>
+
+#include "Token.h"
+
+namespace {
+
+	// FNV-1a: i nomi sono corti, basta un hash byte per byte
+	std::uint32_t hashWord(std::string_view word) {
+		std::uint32_t h = 2166136261u;
+		for (char c : word)
+			h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+		return h;
+	}
+
+}
+
+
+AtomTable::AtomTable() : slots(1024, EMPTY), hashes(1024, 0), text{ 16 * 1024 } {}
+
+
+AtomTable& AtomTable::global() {
+	static AtomTable table;
+	return table;
+}
+
+
+Atom AtomTable::intern(std::string_view word) {
+	std::lock_guard<std::mutex> lock{ mutex };
+	return internLocked(word);
+}
+
+
+void AtomTable::internIds(Token* first, Token* last, const char* base) {
+	std::lock_guard<std::mutex> lock{ mutex };
+	for (Token* t = first; t != last; ++t)
+		if (t->tag == Token::ID)
+			t->value = static_cast<std::int32_t>(internLocked(std::string_view{ base + t->offset, t->length }));
+}
+
+
+Atom AtomTable::internLocked(std::string_view word) {
+	const std::uint32_t h = hashWord(word);
+	const std::size_t mask = slots.size() - 1;
+	for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+		Atom atom = slots[i];
+		if (atom == EMPTY) {
+			char* copy = text.allocateArray<char>(word.size());
+			std::memcpy(copy, word.data(), word.size());
+			atom = static_cast<Atom>(words.size());
+			words.emplace_back(copy, word.size());
+			slots[i] = atom;
+			hashes[i] = h;
+			// al massimo meta' delle posizioni occupate
+			if (words.size() * 2 > slots.size())
+				grow();
+			return atom;
+		}
+		if (hashes[i] == h && words[atom] == word)
+			return atom;
+	}
+}
+
+
+void AtomTable::grow() {
+	std::vector<Atom> oldSlots = std::move(slots);
+	std::vector<std::uint32_t> oldHashes = std::move(hashes);
+	slots.assign(oldSlots.size() * 2, EMPTY);
+	hashes.assign(oldHashes.size() * 2, 0);
+
+	const std::size_t mask = slots.size() - 1;
+	for (std::size_t j = 0; j < oldSlots.size(); ++j) {
+		if (oldSlots[j] == EMPTY)
+			continue;
+		std::size_t i = oldHashes[j] & mask;
+		while (slots[i] != EMPTY)
+			i = (i + 1) & mask;
+		slots[i] = oldSlots[j];
+		hashes[i] = oldHashes[j];
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef ATOMS_H
+#define ATOMS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "Arena.h"
+
+struct Token;
+
+// Identificatore ridotto a un intero: due nomi sono uguali se e solo se lo
+// sono i loro atomi
+using Atom = std::uint32_t;
+
+// Tabella degli atomi: ogni parola distinta viene memorizzata una volta sola
+// e riceve il primo intero libero. La tabella globale e' condivisa da tutto
+// il processo, quindi anche da piu' file analizzati nella stessa esecuzione.
+// intern() puo' essere chiamata da piu' thread; spelling() non deve essere
+// chiamata mentre un altro thread aggiunge atomi (nel compilatore gli atomi
+// vengono aggiunti solo durante il lessing).
+class AtomTable {
+
+public:
+	AtomTable();
+	AtomTable(AtomTable const&) = delete;
+	AtomTable& operator=(AtomTable const&) = delete;
+
+	static AtomTable& global();
+
+	Atom intern(std::string_view word);
+
+	// Assegna a ogni token ID di [first, last) (le cui parole sono in base)
+	// l'atomo del suo nome, nel campo value
+	void internIds(Token* first, Token* last, const char* base);
+
+	std::string_view spelling(Atom atom) const { return words[atom]; }
+
+	std::size_t size() const { return words.size(); }
+
+private:
+	Atom internLocked(std::string_view word);
+	void grow();
+
+	static constexpr Atom EMPTY = UINT32_MAX;
+
+	std::mutex mutex;
+
+	// indirizzamento aperto con scansione lineare: slots contiene gli atomi
+	// (EMPTY se libero), hashes i rispettivi hash per evitare di confrontare
+	// le parole quando differiscono
+	std::vector<Atom> slots;
+	std::vector<std::uint32_t> hashes;
+	std::vector<std::string_view> words;
+	Arena text;
+};
+
+#endif
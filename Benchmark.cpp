@@ -0,0 +1,781 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BytecodeCompiler.h"
+#include "CompactAst.h"
+#include "CompactParser.h"
+#include "CompileCache.h"
+#include "EvaluationVisitor.h"
+#include "ExpressionManager.h"
+#include "IncrementalParser.h"
+#include "Keywords.h"
+#include "Parser.h"
+#include "ProgramImage.h"
+#include "Resolver.h"
+#include "ScanKernels.h"
+#include "SourceBuffer.h"
+#include "Tokenizer.h"
+#include "VirtualMachine.h"
+#include "Visitor.h"
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	// Ripete f finche' non sono trascorsi almeno minSeconds secondi
+	// e restituisce il tempo medio di una singola esecuzione
+	template <typename F>
+	double secondsPerRun(F f, double minSeconds = 0.5) {
+		int runs = 0;
+		auto start = Clock::now();
+		std::chrono::duration<double> elapsed{};
+		do {
+			f();
+			++runs;
+			elapsed = Clock::now() - start;
+		} while (elapsed.count() < minSeconds);
+		return elapsed.count() / runs;
+	}
+
+	// Ricerca delle keyword come faceva il Tokenizer prima di Keywords.h:
+	// confronto con ognuna delle keyword, costruendo ogni volta una stringa
+	int linearKeywordLookup(const std::string& word) {
+		for (int i = 0; i < Token::keywordsIdSize; i++) {
+			int keyword_id = Token::keywordsId[i];
+			if (std::string(Token::id2word[keyword_id]) == word)
+				return keyword_id;
+		}
+		return -1;
+	}
+
+	// Sorgente sintatticamente plausibile composto quasi solo da
+	// identificatori (alcuni simili alle keyword) e qualche keyword
+	std::string identifierHeavySource(std::size_t targetBytes) {
+		static const char* words[]{
+			"counter", "i", "index", "whilst", "done", "iff", "printer", "integer",
+			"boolean", "elsewhere", "truth", "falsehood", "breakpoint", "x1", "accumulator",
+			"if", "while", "print", "int", "do", "temp", "value", "isprime", "n"
+		};
+		std::string source;
+		source.reserve(targetBytes + 64);
+		unsigned seed = 12345;
+		while (source.size() < targetBytes) {
+			seed = seed * 1103515245u + 12345u;
+			source += words[(seed >> 16) % (sizeof(words) / sizeof(words[0]))];
+			source += (seed & 0x100) ? " = " : " ";
+			if ((seed & 0x7000) == 0)
+				source += ";\n";
+		}
+		return source;
+	}
+
+	void report(const char* name, std::size_t bytes, double seconds) {
+		double mb = bytes / (1024.0 * 1024.0);
+		std::cout << std::left << std::setw(24) << name
+			<< std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << seconds * 1000.0 << " ms"
+			<< std::setw(12) << mb / seconds << " MB/s" << std::endl;
+	}
+
+	// Programma con cicli annidati e accessi a un vettore di size elementi:
+	// riempimento, ordinamento per inserimento e conteggio dei primi minori
+	// di 4 * size per divisioni successive
+	std::string loopSource(int size) {
+		const std::string n = std::to_string(size);
+		return "{\n"
+			"  int[" + n + "] v;\n"
+			"  int n; int i; int j; int key; int count;\n"
+			"  boolean prime;\n"
+			"  n = " + n + ";\n"
+			"  i = 0;\n"
+			"  while (i < n) {\n"
+			"    v[i] = i * 7919 - (i * 7919 / 1000) * 1000;\n"
+			"    i = i + 1;\n"
+			"  }\n"
+			"  i = 1;\n"
+			"  while (i < n) {\n"
+			"    key = v[i];\n"
+			"    j = i - 1;\n"
+			"    while (j >= 0 && v[j] > key) {\n"
+			"      v[j + 1] = v[j];\n"
+			"      j = j - 1;\n"
+			"    }\n"
+			"    v[j + 1] = key;\n"
+			"    i = i + 1;\n"
+			"  }\n"
+			"  count = 0;\n"
+			"  i = 2;\n"
+			"  while (i < 4 * n) {\n"
+			"    prime = true;\n"
+			"    j = 2;\n"
+			"    while (j * j <= i && prime) {\n"
+			"      if (i - (i / j) * j == 0) {\n"
+			"        prime = false;\n"
+			"      }\n"
+			"      j = j + 1;\n"
+			"    }\n"
+			"    if (prime) {\n"
+			"      count = count + 1;\n"
+			"      print(i);\n"
+			"    }\n"
+			"    i = i + 1;\n"
+			"  }\n"
+			"  print(v[0]);\n"
+			"  print(v[n - 1]);\n"
+			"  print(count);\n"
+			"}\n";
+	}
+
+	// Tempo di una visita, anche per nodo; same == false segnala un risultato
+	// diverso da quello di riferimento
+	void visitReport(const char* name, double seconds, std::size_t nodes, bool same) {
+		std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setw(10)
+			<< std::setprecision(3) << seconds * 1e3 << " ms" << std::setw(12) << std::setprecision(2)
+			<< seconds * 1e9 / nodes << " ns/nodo" << (same ? "" : "  RISULTATO DIVERSO") << std::endl;
+	}
+
+	// Visita completa dell'AST a puntatori che somma i valori delle costanti
+	class NodeSum : public Visitor {
+
+	public:
+		long long sum = 0;
+
+		void visitProgram(Program* program) override { program->getBlock()->accept(this); }
+		void visitBlock(Block* block) override {
+			if (block->getDecls())
+				block->getDecls()->accept(this);
+			if (block->getStmts())
+				block->getStmts()->accept(this);
+		}
+		void visitType(Type*) override {}
+		void visitVectorType(vectorType*) override {}
+		void visitDecls(Decls* decls) override {
+			for (Decl* decl : *decls)
+				decl->accept(this);
+		}
+		void visitDecl(Decl* decl) override {
+			decl->getType()->accept(this);
+			decl->getId()->accept(this);
+		}
+		void visitId(Id*) override { ++sum; }
+		void visitStmts(Stmts* stmts) override {
+			for (Stmt* stmt : *stmts)
+				stmt->accept(this);
+		}
+		void visitIntConstant(intConstant* numNode) override { sum += numNode->getValue(); }
+		void visitBoolConstant(boolConstant* boolNode) override { sum += boolNode->getValue(); }
+		void visitBinOp(Arithm* arithmNode) override { both(arithmNode->getLeftExp(), arithmNode->getRightExp()); }
+		void visitUnaryOp(Unary* unaryNode) override { unaryNode->getExp()->accept(this); }
+		void visitAccess(Access* accessNode) override { both(accessNode->getId(), accessNode->getIndex()); }
+		void visitIf(If* ifNode) override { both(ifNode->getCondition(), ifNode->getStmt()); }
+		void visitElse(Else* elseNode) override {
+			both(elseNode->getCondition(), elseNode->getifTrueStmt());
+			elseNode->getifFalseStmt()->accept(this);
+		}
+		void visitWhile(While* whileNode) override { both(whileNode->getCondition(), whileNode->getStmt()); }
+		void visitDo(Do* doNode) override { both(doNode->getCondition(), doNode->getStmt()); }
+		void visitSet(Set* setNode) override { both(setNode->getId(), setNode->getExp()); }
+		void visitSetElem(SetElem* setElemNode) override {
+			both(setElemNode->getId(), setElemNode->getIndex());
+			setElemNode->getExp()->accept(this);
+		}
+		void visitBreak(Break*) override {}
+		void visitPrint(Print* printNode) override { printNode->getExp()->accept(this); }
+		void visitNot(Not* notNode) override { notNode->getExp()->accept(this); }
+		void visitAnd(And* andNode) override { both(andNode->getLeftExp(), andNode->getRightExp()); }
+		void visitOr(Or* orNode) override { both(orNode->getLeftExp(), orNode->getRightExp()); }
+		void visitRel(Rel* relNode) override { both(relNode->getLeftExp(), relNode->getRightExp()); }
+
+	private:
+		void both(Node* first, Node* second) {
+			first->accept(this);
+			second->accept(this);
+		}
+	};
+
+	// La stessa visita con StaticVisitor: gli altri nodi usano la visita
+	// dei figli predefinita
+	class StaticSum : public StaticVisitor<StaticSum> {
+
+	public:
+		long long sum = 0;
+
+		void visitId(Id*) { ++sum; }
+		void visitIntConstant(intConstant* numNode) { sum += numNode->getValue(); }
+		void visitBoolConstant(boolConstant* boolNode) { sum += boolNode->getValue(); }
+	};
+
+	// La stessa visita sull'AST a puntatori con dispatch: lo switch sul tipo
+	// del nodo sostituisce le chiamate virtuali di accept e di visitXxx
+	long long switchSum(Node* node) {
+		return dispatch(node, [](auto* n) -> long long {
+			using T = std::remove_pointer_t<decltype(n)>;
+			if constexpr (std::is_same_v<T, Id>)
+				return 1;
+			else if constexpr (std::is_same_v<T, intConstant> || std::is_same_v<T, boolConstant>)
+				return n->getValue();
+			else if constexpr (std::is_same_v<T, Program>)
+				return switchSum(n->getBlock());
+			else if constexpr (std::is_same_v<T, Block>)
+				return (n->getDecls() ? switchSum(n->getDecls()) : 0)
+					+ (n->getStmts() ? switchSum(n->getStmts()) : 0);
+			else if constexpr (std::is_same_v<T, Decls> || std::is_same_v<T, Stmts>) {
+				long long sum = 0;
+				for (auto* child : *n)
+					sum += switchSum(child);
+				return sum;
+			}
+			else if constexpr (std::is_same_v<T, Decl>)
+				return switchSum(n->getType()) + switchSum(n->getId());
+			else if constexpr (std::is_same_v<T, Unary> || std::is_same_v<T, Not> || std::is_same_v<T, Print>)
+				return switchSum(n->getExp());
+			else if constexpr (std::is_same_v<T, Arithm> || std::is_same_v<T, And>
+				|| std::is_same_v<T, Or> || std::is_same_v<T, Rel>)
+				return switchSum(n->getLeftExp()) + switchSum(n->getRightExp());
+			else if constexpr (std::is_same_v<T, Access>)
+				return switchSum(n->getId()) + switchSum(n->getIndex());
+			else if constexpr (std::is_same_v<T, If> || std::is_same_v<T, While> || std::is_same_v<T, Do>)
+				return switchSum(n->getCondition()) + switchSum(n->getStmt());
+			else if constexpr (std::is_same_v<T, Else>)
+				return switchSum(n->getCondition()) + switchSum(n->getifTrueStmt()) + switchSum(n->getifFalseStmt());
+			else if constexpr (std::is_same_v<T, Set>)
+				return switchSum(n->getId()) + switchSum(n->getExp());
+			else if constexpr (std::is_same_v<T, SetElem>)
+				return switchSum(n->getId()) + switchSum(n->getIndex()) + switchSum(n->getExp());
+			else
+				return 0;
+		});
+	}
+
+	// La stessa visita sull'AST compatto, con CompactAst::forEachChild
+	long long compactSum(const CompactAst& ast, CompactAst::NodeId n) {
+		switch (ast.kind(n)) {
+		case CompactAst::ID:
+			return 1;
+		case CompactAst::INT_CONSTANT:
+		case CompactAst::BOOL_CONSTANT:
+			return ast.intValue(n);
+		case CompactAst::VECTOR_DECL:
+			return compactSum(ast, ast.a(n));
+		default:
+		{
+			long long sum = 0;
+			ast.forEachChild(n, [&](CompactAst::NodeId child) { sum += compactSum(ast, child); });
+			return sum;
+		}
+		}
+	}
+
+}
+
+void Benchmark::lexer(const std::string& path) {
+	std::size_t bytes = SourceBuffer{ path }.size();
+	std::size_t tokens = 0;
+	Tokenizer tokenize;
+
+	double streamTime = secondsPerRun([&] {
+		std::ifstream inputFile(path);
+		tokens = tokenize(inputFile).size();
+	});
+	double bufferTime = secondsPerRun([&] {
+		tokens = tokenize(path).size();
+	});
+
+	std::cout << path << ": " << bytes << " byte, " << tokens << " token" << std::endl;
+	report("std::ifstream", bytes, streamTime);
+	report("SourceBuffer (mmap)", bytes, bufferTime);
+	std::cout << "speedup " << std::setprecision(2) << streamTime / bufferTime << "x" << std::endl;
+}
+
+void Benchmark::keywords() {
+	std::string source = identifierHeavySource(8 * 1024 * 1024);
+	Tokenizer tokenize;
+	std::size_t tokens = 0;
+
+	double lexTime = secondsPerRun([&] {
+		tokens = tokenize(source.data(), source.size()).size();
+	});
+
+	// parole da classificare, estratte dallo stesso sorgente
+	TokenStream stream = tokenize(source.data(), source.size());
+	std::vector<std::string> words;
+	for (const Token& t : stream)
+		if (t.tag == Token::ID || (t.tag >= Token::IF && t.tag <= Token::PRINT))
+			words.push_back(std::string(stream.spelling(t)));
+
+	long long sink = 0;
+	double linearTime = secondsPerRun([&] {
+		for (const std::string& w : words)
+			sink += linearKeywordLookup(w);
+	});
+	double hashTime = secondsPerRun([&] {
+		for (const std::string& w : words)
+			sink += Keywords::lookup(w);
+	});
+
+	std::cout << "sorgente generato: " << source.size() << " byte, " << tokens << " token, "
+		<< words.size() << " parole" << std::endl;
+	report("lessing", source.size(), lexTime);
+	std::cout << std::left << std::setw(24) << "keyword lineare" << std::right << std::setw(10)
+		<< linearTime * 1e9 / words.size() << " ns/parola" << std::endl;
+	std::cout << std::left << std::setw(24) << "keyword hash perfetto" << std::right << std::setw(10)
+		<< hashTime * 1e9 / words.size() << " ns/parola" << std::endl;
+	std::cout << "speedup " << std::setprecision(2) << linearTime / hashTime << "x"
+		<< (sink == 42 ? " " : "") << std::endl;
+}
+
+void Benchmark::scanKernels(const std::string& path) {
+	SourceBuffer source{ path };
+	Tokenizer tokenize;
+	std::size_t tokens = 0;
+	ScanKernels::Isa original = ScanKernels::activeIsa();
+
+	std::cout << path << ": " << source.size() << " byte" << std::endl;
+	double scalarTime = 0;
+	for (ScanKernels::Isa isa : { ScanKernels::Isa::SCALAR, ScanKernels::Isa::SSE2, ScanKernels::Isa::AVX2 }) {
+		if (!ScanKernels::use(isa))
+			continue;
+		double time = secondsPerRun([&] {
+			tokens = tokenize(source.data(), source.size()).size();
+		});
+		if (isa == ScanKernels::Isa::SCALAR)
+			scalarTime = time;
+		report(ScanKernels::isaName(isa), source.size(), time);
+		std::cout << "  speedup " << std::setprecision(2) << scalarTime / time << "x, "
+			<< tokens << " token" << std::endl;
+	}
+	ScanKernels::use(original);
+}
+
+void Benchmark::parallelLexer(const std::string& path) {
+	SourceBuffer source{ path };
+	const std::vector<Token> serial = Tokenizer{}(source.data(), source.size()).getTokens();
+
+	unsigned cores = std::thread::hardware_concurrency();
+	unsigned maxThreads = std::max(4u, cores);
+	std::cout << path << ": " << source.size() << " byte, " << serial.size() - 1
+		<< " token, " << cores << " core" << std::endl;
+
+	double serialTime = 0;
+	for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+		Tokenizer tokenize{ threads };
+		bool identical = true;
+		double time = secondsPerRun([&] {
+			TokenStream stream = tokenize(source.data(), source.size());
+			const std::vector<Token>& tokens = stream.getTokens();
+			identical = identical && tokens.size() == serial.size();
+			for (std::size_t i = 0; identical && i < tokens.size(); ++i)
+				identical = tokens[i].tag == serial[i].tag && tokens[i].offset == serial[i].offset
+					&& tokens[i].length == serial[i].length && tokens[i].value == serial[i].value;
+		});
+		if (threads == 1)
+			serialTime = time;
+		std::string name = std::to_string(threads) + " thread";
+		report(name.c_str(), source.size(), time);
+		std::cout << "  scaling " << std::setprecision(2) << serialTime / time << "x"
+			<< (identical ? "" : "  TOKEN DIVERSI DAL LESSING SERIALE") << std::endl;
+	}
+}
+
+void Benchmark::parser(const std::string& path) {
+	TokenStream stream = Tokenizer{}(path);
+	std::size_t bytes = stream.getSource().size();
+
+	double time = secondsPerRun([&] {
+		ExpressionManager manager;
+		Parser parse(manager, stream);
+		parse();
+	});
+
+	std::cout << path << ": " << bytes << " byte, " << stream.size() << " token" << std::endl;
+	report("parsing", bytes, time);
+	std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10)
+		<< std::setprecision(1) << time * 1e9 / stream.size() << " ns/token" << std::endl;
+
+	// lo stesso manager per tutti i parsing: clearMemory() rende riusabile
+	// la memoria dell'arena, che non viene chiesta di nuovo al sistema
+	ExpressionManager reused;
+	double reuseTime = secondsPerRun([&] {
+		reused.clearMemory();
+		Parser parse(reused, stream);
+		parse();
+	});
+	report("manager riusato", bytes, reuseTime);
+	std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10)
+		<< reused.nodeCount() << " nodi, " << reused.bytesUsed() << " byte" << std::endl;
+
+	// nodi condivisi (hash-consing): l'AST diventa un DAG
+	const std::pair<const char*, NodeSharing> modes[]{
+		{ "condivisione foglie", NodeSharing::LEAVES },
+		{ "condivisione espr.", NodeSharing::EXPRESSIONS }
+	};
+	for (const auto& mode : modes) {
+		ExpressionManager shared{ mode.second };
+		double sharedTime = secondsPerRun([&] {
+			shared.clearMemory();
+			Parser parse(shared, stream);
+			parse();
+		});
+		report(mode.first, bytes, sharedTime);
+		std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10)
+			<< shared.nodeCount() << " nodi, " << shared.bytesUsed() << " byte" << std::endl;
+	}
+
+	// Parsing pigro: tempo per avere il primo livello del programma
+	// (compresa la scansione delle parentesi) e nodi allocati, confrontati
+	// con il parsing completo; poi il costo di materializzare tutti i blocchi
+	std::size_t strictNodes = 0, lazyNodes = 0;
+	{
+		ExpressionManager manager;
+		Parser parse(manager, stream, ParseMode::STRICT);
+		parse();
+		strictNodes = manager.nodeCount();
+	}
+	double lazyTime = secondsPerRun([&] {
+		ExpressionManager manager;
+		Parser parse(manager, stream, ParseMode::LAZY);
+		parse();
+		lazyNodes = manager.nodeCount();
+	});
+	double fullTime = secondsPerRun([&] {
+		ExpressionManager manager;
+		Parser parse(manager, stream, ParseMode::LAZY);
+		std::ostringstream out;
+		PrintVisitor print(out);
+		parse()->accept(&print);
+	});
+	double printTime = secondsPerRun([&] {
+		ExpressionManager manager;
+		Parser parse(manager, stream, ParseMode::STRICT);
+		std::ostringstream out;
+		PrintVisitor print(out);
+		parse()->accept(&print);
+	});
+
+	report("parsing pigro", bytes, lazyTime);
+	std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10)
+		<< lazyNodes << " nodi (" << strictNodes << " nel parsing completo)" << std::endl;
+	report("stretto + stampa", bytes, printTime);
+	report("pigro + stampa", bytes, fullTime);
+}
+
+void Benchmark::parallelParser(const std::string& path) {
+	TokenStream stream = Tokenizer{}(path);
+	std::size_t bytes = stream.getSource().size();
+
+	auto printed = [&](unsigned threads) {
+		ExpressionManager manager;
+		Parser parse(manager, stream, ParseMode::STRICT, threads);
+		std::ostringstream out;
+		PrintVisitor print(out);
+		parse()->accept(&print);
+		return out.str();
+	};
+	const std::string serial = printed(1);
+
+	unsigned cores = std::thread::hardware_concurrency();
+	unsigned maxThreads = std::max(4u, cores);
+	std::cout << path << ": " << bytes << " byte, " << stream.size()
+		<< " token, " << cores << " core" << std::endl;
+
+	double serialTime = 0;
+	for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+		double time = secondsPerRun([&] {
+			ExpressionManager manager;
+			Parser parse(manager, stream, ParseMode::STRICT, threads);
+			parse();
+		});
+		if (threads == 1)
+			serialTime = time;
+		bool identical = printed(threads) == serial;
+		std::string name = std::to_string(threads) + " thread";
+		report(name.c_str(), bytes, time);
+		std::cout << "  scaling " << std::setprecision(2) << serialTime / time << "x"
+			<< (identical ? "" : "  AST DIVERSO DAL PARSING SERIALE") << std::endl;
+	}
+}
+
+void Benchmark::incremental(const std::string& path) {
+	SourceBuffer buffer{ path };
+	const std::string original(buffer.data(), buffer.size());
+
+	auto printed = [](Program* program) {
+		std::ostringstream out;
+		PrintVisitor print(out);
+		program->accept(&print);
+		return out.str();
+	};
+
+	IncrementalParser session;
+	double fullTime = secondsPerRun([&] { session.parse(original); });
+	std::cout << path << ": " << original.size() << " byte, " << session.getTokens().size() << " token" << std::endl;
+	report("analisi completa", original.size(), fullTime);
+
+	// modifiche di una sola cifra in punti distribuiti nel file; ogni
+	// modifica viene poi annullata con un secondo aggiornamento
+	std::vector<std::size_t> digits;
+	for (const Token& token : session.getTokens())
+		if (token.tag == Token::NUM)
+			digits.push_back(token.offset);
+	const std::size_t edits = std::min<std::size_t>(50, digits.size());
+	const std::size_t verified = 10;
+
+	std::vector<double> times;
+	std::size_t relexed = 0, blockTokens = 0, full = 0;
+	bool identical = true;
+	for (std::size_t e = 0; e < edits; ++e) {
+		std::string edited = original;
+		char& digit = edited[digits[e * digits.size() / edits]];
+		digit = digit == '9' ? '1' : digit + 1;
+
+		const std::string* versions[]{ &edited, &original };
+		for (const std::string* version : versions) {
+			auto start = Clock::now();
+			session.update(*version);
+			times.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+			relexed += session.lastStats().tokensRelexed;
+			blockTokens += session.lastStats().blockTokens;
+			full += session.lastStats().fullParse;
+		}
+		if (e < verified) {
+			session.update(edited);
+			ExpressionManager manager;
+			TokenStream stream = Tokenizer{}(edited.data(), edited.size());
+			Parser parse(manager, stream);
+			identical = identical && printed(session.getProgram()) == printed(parse());
+			session.update(original);
+		}
+	}
+	if (times.empty())
+		return;
+
+	std::sort(times.begin(), times.end());
+	std::cout << std::left << std::setw(24) << "aggiornamento" << std::right << std::setw(10)
+		<< std::setprecision(3) << times[times.size() / 2] * 1e3 << " ms mediana, "
+		<< times.back() * 1e3 << " ms massimo (" << times.size() << " aggiornamenti, "
+		<< full << " completi)" << std::endl;
+	std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10)
+		<< relexed / times.size() << " token rilessati, " << blockTokens / times.size()
+		<< " token rianalizzati in media" << (identical ? "" : "  AST DIVERSO DALL'ANALISI COMPLETA") << std::endl;
+}
+
+void Benchmark::compileCache(const std::string& path) {
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "compilatore-bench-cache";
+	std::filesystem::remove_all(directory);
+	CompileCache cache{ directory.string() };
+	const std::uint64_t compiler = CompileCache::compilerHash();
+
+	// lessing, parsing e stampa a partire dal file, come senza --cache
+	std::string expected;
+	double coldTime = secondsPerRun([&] {
+		TokenStream stream = Tokenizer{}(path);
+		ExpressionManager manager;
+		Parser parse(manager, stream);
+		std::ostringstream out;
+		PrintVisitor print(out);
+		parse()->accept(&print);
+		expected = out.str();
+	});
+
+	TokenStream stream = Tokenizer{}(path);
+	const SourceBuffer& source = stream.getSource();
+	const std::uint64_t sourceHash = CompileCache::hash(source.data(), source.size());
+	ExpressionManager manager;
+	Parser parse(manager, stream);
+	Program* program = parse();
+
+	std::size_t imageBytes = 0;
+	double storeTime = secondsPerRun([&] {
+		std::string image = ProgramImage::build(program, stream, compiler, sourceHash);
+		imageBytes = image.size();
+		cache.store(sourceHash, image);
+	});
+
+	// il sorgente va comunque letto per calcolarne l'hash
+	std::string printed;
+	bool found = true;
+	double warmTime = secondsPerRun([&] {
+		SourceBuffer file{ path };
+		CompileCache::Entry entry;
+		found = cache.lookup(CompileCache::hash(file.data(), file.size()), file.size(), entry);
+		if (!found)
+			return;
+		std::ostringstream out;
+		ProgramImage::print(entry.image, out);
+		printed = out.str();
+	});
+	std::filesystem::remove_all(directory);
+
+	std::cout << path << ": " << source.size() << " byte, " << stream.size()
+		<< " token, immagine di " << imageBytes << " byte" << std::endl;
+	report("senza cache", source.size(), coldTime);
+	report("salvataggio immagine", source.size(), storeTime);
+	report("con cache", source.size(), warmTime);
+	std::cout << "  " << std::setprecision(1) << coldTime / warmTime << "x piu' veloce"
+		<< (!found ? "  IMMAGINE NON TROVATA" : printed != expected ? "  STAMPA DIVERSA" : "") << std::endl;
+}
+
+void Benchmark::compactAst(const std::string& path) {
+	TokenStream stream = Tokenizer{}(path);
+	std::size_t bytes = stream.getSource().size();
+
+	ExpressionManager manager;
+	double pointerTime = secondsPerRun([&] {
+		manager.clearMemory();
+		Parser parse(manager, stream);
+		parse();
+	});
+	manager.clearMemory();
+	Program* program = Parser(manager, stream)();
+
+	CompactAst ast;
+	double compactTime = secondsPerRun([&] {
+		ast.clear();
+		CompactParser parse(ast, stream);
+		parse();
+	});
+
+	std::ostringstream pointerOut, compactOut;
+	PrintVisitor print(pointerOut);
+	program->accept(&print);
+	::print(ast, compactOut);
+
+	std::cout << path << ": " << bytes << " byte, " << stream.size() << " token" << std::endl;
+	report("parsing, puntatori", bytes, pointerTime);
+	std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10) << manager.nodeCount()
+		<< " nodi, " << std::setprecision(1) << double(manager.bytesUsed()) / manager.nodeCount() << " byte/nodo" << std::endl;
+	report("parsing, compatto", bytes, compactTime);
+	std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10) << ast.size()
+		<< " nodi, " << std::setprecision(1) << double(ast.bytes()) / ast.size() << " byte/nodo"
+		<< (pointerOut.str() == compactOut.str() ? "" : "  STAMPA DIVERSA") << std::endl;
+
+	// visita completa: Visitor (accept e visitXxx) e dispatch sui nodi a
+	// puntatori, switch sul tipo del nodo compatto e scansione lineare delle
+	// colonne (i nodi sono gia' in ordine)
+	long long pointerSum = 0, switchTotal = 0, compactTotal = 0, scanTotal = 0;
+	double pointerVisit = secondsPerRun([&] {
+		NodeSum sum;
+		program->accept(&sum);
+		pointerSum = sum.sum;
+	});
+	double switchVisit = secondsPerRun([&] { switchTotal = switchSum(program); });
+	double compactVisit = secondsPerRun([&] { compactTotal = compactSum(ast, ast.root()); });
+	double scanVisit = secondsPerRun([&] {
+		long long total = 0;
+		for (CompactAst::NodeId n = 0; n < ast.size(); ++n) {
+			CompactAst::Kind kind = ast.kind(n);
+			if (kind == CompactAst::ID)
+				++total;
+			else if (kind == CompactAst::INT_CONSTANT || kind == CompactAst::BOOL_CONSTANT)
+				total += ast.intValue(n);
+		}
+		scanTotal = total;
+	});
+
+	visitReport("visita, puntatori", pointerVisit, manager.nodeCount(), true);
+	visitReport("visita, dispatch", switchVisit, manager.nodeCount(), switchTotal == pointerSum);
+	visitReport("visita, compatto", compactVisit, ast.size(), compactTotal == pointerSum);
+	visitReport("scansione, compatto", scanVisit, ast.size(), scanTotal == pointerSum);
+}
+
+void Benchmark::visitors(const std::string& path) {
+	TokenStream stream = Tokenizer{}(path);
+	ExpressionManager manager;
+	Program* program = Parser(manager, stream)();
+	const std::size_t nodes = manager.nodeCount();
+	std::cout << path << ": " << stream.size() << " token, " << nodes << " nodi" << std::endl;
+
+	long long virtualTotal = 0, staticTotal = 0, switchTotal = 0;
+	double virtualVisit = secondsPerRun([&] {
+		NodeSum sum;
+		program->accept(&sum);
+		virtualTotal = sum.sum;
+	});
+	double staticVisit = secondsPerRun([&] {
+		StaticSum sum;
+		sum.visit(program);
+		staticTotal = sum.sum;
+	});
+	double switchVisit = secondsPerRun([&] { switchTotal = switchSum(program); });
+
+	std::size_t counted = 0;
+	double countVisit = secondsPerRun([&] {
+		NodeCounter counter;
+		counter.visit(program);
+		counted = counter.total();
+	});
+
+	std::size_t printed = 0;
+	double printVisit = secondsPerRun([&] {
+		std::ostringstream out;
+		PrintVisitor print(out);
+		program->accept(&print);
+		printed = out.str().size();
+	});
+
+	visitReport("somma, Visitor", virtualVisit, nodes, true);
+	visitReport("somma, StaticVisitor", staticVisit, nodes, staticTotal == virtualTotal);
+	visitReport("somma, dispatch", switchVisit, nodes, switchTotal == virtualTotal);
+	visitReport("conteggio, NodeCounter", countVisit, nodes, counted == nodes);
+	visitReport("stampa, PrintVisitor", printVisit, nodes, printed > 0);
+}
+
+void Benchmark::evaluator(const std::string& path) {
+	struct Source {
+		std::string name;
+		std::string text;
+	};
+	SourceBuffer file{ path };
+	const std::vector<Source> sources{
+		{ path, std::string(file.data(), file.size()) },
+		{ "cicli generati", loopSource(3000) }
+	};
+
+	for (const Source& source : sources) {
+		TokenStream stream = Tokenizer{}(source.text.data(), source.text.size());
+		ExpressionManager manager;
+		Program* program = Parser(manager, stream)();
+		Resolver{ manager }.resolve(program);
+
+		std::string output;
+		double treeTime = secondsPerRun([&] {
+			std::ostringstream out;
+			EvaluationVisitor{ out }.run(program);
+			output = out.str();
+		});
+
+		// la compilazione in bytecode e' misurata a parte dall'esecuzione
+		Bytecode bytecode;
+		double compileTime = secondsPerRun([&] { bytecode = BytecodeCompiler{}.compile(program); });
+		std::string vmOutput;
+		double vmTime = secondsPerRun([&] {
+			std::ostringstream out;
+			VirtualMachine{ out }.run(bytecode);
+			vmOutput = out.str();
+		});
+
+		std::cout << source.name << ": " << manager.nodeCount() << " nodi, "
+			<< output.size() << " byte stampati, " << bytecode.code.size() << " istruzioni" << std::endl;
+		auto row = [](const char* name, double seconds) {
+			std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setw(10)
+				<< std::setprecision(3) << seconds * 1e3 << " ms" << std::endl;
+		};
+		row("albero", treeTime);
+		row("compilazione bytecode", compileTime);
+		row("vm", vmTime);
+		std::cout << "accelerazione della vm: " << std::setprecision(1) << treeTime / vmTime << "x" << std::endl;
+		if (vmOutput != output)
+			std::cout << "ATTENZIONE: la vm stampa un risultato diverso dall'albero" << std::endl;
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+// Misure di prestazione richiamabili da riga di comando (opzioni --bench-*).
+// I risultati vengono stampati su std::cout in forma leggibile.
+namespace Benchmark {
+
+	// Confronta il lessing a stream (std::ifstream) con quello a buffer
+	// contiguo sullo stesso file, riportando i MB/s di ciascuno
+	void lexer(const std::string& path);
+
+	// Lessing di un sorgente generato ricco di identificatori e confronto
+	// fra la ricerca lineare delle keyword e l'hash perfetto di Keywords.h
+	void keywords();
+
+	// Lessing dello stesso file con ciascun insieme di kernel di scansione
+	// supportato dalla CPU (scalare, SSE2, AVX2)
+	void scanKernels(const std::string& path);
+
+	// Lessing parallelo a blocchi con 1, 2, 4, ... thread (fino al numero di
+	// core, almeno 4), verificando che i token coincidano con quelli seriali
+	void parallelLexer(const std::string& path);
+
+	// Tempo del solo parsing (il file viene lessato una volta sola)
+	void parser(const std::string& path);
+
+	// Parsing parallelo con 1, 2, 4, ... thread, verificando che l'AST
+	// stampato coincida con quello del parsing seriale
+	void parallelParser(const std::string& path);
+
+	// Analisi incrementale (IncrementalParser) dopo la modifica di una cifra
+	// in vari punti del file, confrontata con l'analisi completa; per le
+	// prime modifiche si verifica che l'AST coincida con quello completo
+	void incremental(const std::string& path);
+
+	// Compilazione con la cache su disco (CompileCache): analisi e stampa
+	// senza cache, costo del salvataggio dell'immagine e uso dell'immagine
+	// gia' salvata, verificando che la stampa coincida
+	void compileCache(const std::string& path);
+
+	// AST compatto (CompactAst) confrontato con quello a puntatori: tempo
+	// di parsing, byte per nodo e velocita' di visita (anche con dispatch
+	// sull'AST a puntatori), verificando che la stampa coincida
+	void compactAst(const std::string& path);
+
+	// Visita completa dell'AST con il Visitor astratto (doppio dispatch
+	// virtuale), con StaticVisitor e con dispatch, verificando che i
+	// risultati coincidano; conteggio dei nodi e stampa con PrintVisitor
+	void visitors(const std::string& path);
+
+	// Esecuzione del programma del file e di uno generato ricco di cicli
+	// annidati e di accessi a vettori, con l'interprete ad albero e con la
+	// macchina virtuale (l'output viene scartato)
+	void evaluator(const std::string& path);
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef BINARY_OPERATORS_H
+#define BINARY_OPERATORS_H
+
+#include <array>
+
+#include "Node.h"
+#include "Token.h"
+
+// Binary operators of the grammar, shared by Parser and CompactParser
+namespace BinaryOperators {
+
+// How a binary operator token builds its node
+enum class BinaryKind { NONE, OR, AND, ARITHM, REL };
+
+struct BinaryOperator {
+    int precedence;     // 0: the token is not a binary operator
+    BinaryKind kind;
+    int code;           // Op::BinOpCode or Rel::OpCode
+};
+
+// Precedence of every binary operator, indexed by Token tag. Higher binds
+// tighter; all levels are left associative except Rel, which is not
+// associative (a < b < c is rejected, as in the original grammar):
+//   ||  <  &&  <  == !=  <  < <= > >=  <  + -  <  * /
+constexpr std::array<BinaryOperator, Token::END_OF_INPUT + 1> makeBinaryOperators()
+{
+    std::array<BinaryOperator, Token::END_OF_INPUT + 1> table{};
+    for(auto& op : table)
+        op = BinaryOperator{0, BinaryKind::NONE, 0};
+
+    table[Token::OR]      = {1, BinaryKind::OR, 0};
+    table[Token::AND]     = {2, BinaryKind::AND, 0};
+    table[Token::EQ]      = {3, BinaryKind::ARITHM, Op::EQ};
+    table[Token::NOT_EQ]  = {3, BinaryKind::ARITHM, Op::NOT_EQ};
+    table[Token::LESS]    = {4, BinaryKind::REL, Rel::LESS};
+    table[Token::LESS_EQ] = {4, BinaryKind::REL, Rel::LESS_EQ};
+    table[Token::MORE]    = {4, BinaryKind::REL, Rel::MORE};
+    table[Token::MORE_EQ] = {4, BinaryKind::REL, Rel::MORE_EQ};
+    table[Token::ADD]     = {5, BinaryKind::ARITHM, Op::ADD};
+    table[Token::MIN]     = {5, BinaryKind::ARITHM, Op::SUB};
+    table[Token::MUL]     = {6, BinaryKind::ARITHM, Op::MUL};
+    table[Token::DIV]     = {6, BinaryKind::ARITHM, Op::DIV};
+    return table;
+}
+
+inline constexpr auto binaryOperators = makeBinaryOperators();
+
+// precedence of an operand that is not a binary operation (factor or unary)
+inline constexpr int PRIMARY_PRECEDENCE = 100;
+
+}
+
+#endif
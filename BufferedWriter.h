@@ -0,0 +1,60 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+// Uscita delle istruzioni print: i valori vengono formattati direttamente
+// in un buffer, che passa allo stream solo quando e' pieno o con flush.
+// Anche il distruttore svuota il buffer, cosi' che le stampe eseguite prima
+// di un errore escano comunque (e prima del messaggio di errore).
+class BufferedWriter {
+
+public:
+	explicit BufferedWriter(std::ostream& os) : out{ os }, buffer(CAPACITY) {}
+	BufferedWriter(BufferedWriter const&) = delete;
+	BufferedWriter& operator=(BufferedWriter const&) = delete;
+	~BufferedWriter() { flush(); }
+
+	// Scrive value e un a capo
+	void writeInt(int value) {
+		reserve(16);
+		char* first = buffer.data() + used;
+		char* last = std::to_chars(first, buffer.data() + CAPACITY, value).ptr;
+		*last++ = '\n';
+		used = last - buffer.data();
+	}
+
+	// Scrive true o false e un a capo
+	void writeBool(bool value) {
+		reserve(8);
+		const char* text = value ? "true\n" : "false\n";
+		const std::size_t length = value ? 5 : 6;
+		std::memcpy(buffer.data() + used, text, length);
+		used += length;
+	}
+
+	void flush() {
+		if (used > 0)
+			out.write(buffer.data(), static_cast<std::streamsize>(used));
+		used = 0;
+		out.flush();
+	}
+
+private:
+	static constexpr std::size_t CAPACITY = 64 * 1024;
+
+	void reserve(std::size_t bytes) {
+		if (used + bytes > CAPACITY)
+			flush();
+	}
+
+	std::ostream& out;
+	std::vector<char> buffer;
+	std::size_t used = 0;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Istruzioni della macchina virtuale a pila (VirtualMachine). Gli operandi
+// vengono tolti dalla cima della pila e il risultato vi viene messo al loro
+// posto. I valori sono interi a 32 bit e i booleani valgono 0 o 1: i tipi
+// sono noti durante la compilazione, che al posto di un'operazione con tipi
+// sbagliati emette ERROR.
+enum class OpCode : std::uint8_t {
+	PUSH,                   // arg: costante
+	LOAD,                   // arg: cella, aux: variabile (per i messaggi di errore)
+	STORE,                  // arg: cella
+	LOAD_ELEM,              // arg: prima cella, aux: vettore; l'indice e' sulla pila
+	CHECK_INDEX,            // come LOAD_ELEM, ma controlla solo i limiti e lascia l'indice
+	STORE_ELEM,             // arg: prima cella; indice e valore sulla pila
+	CLEAR,                  // arg: prima cella, aux: numero di celle da rendere non assegnate
+	ADD, SUB, MUL, DIV,
+	EQ, NOT_EQ, MORE, MORE_EQ, LESS, LESS_EQ,
+	NEG, NOT,
+	JUMP,                   // arg: istruzione di destinazione
+	JUMP_IF_FALSE,          // arg: destinazione; toglie la condizione
+	JUMP_IF_TRUE,           // arg: destinazione; toglie la condizione
+	JUMP_IF_FALSE_OR_POP,   // per &&: se salta la condizione resta come risultato
+	JUMP_IF_TRUE_OR_POP,    // per ||: se salta la condizione resta come risultato
+	PRINT_INT,
+	PRINT_BOOL,
+	ERROR,                  // arg: messaggio
+	HALT
+};
+
+struct Instruction {
+	OpCode op;
+	std::uint32_t aux;
+	std::int32_t arg;
+};
+
+// Programma compilato da BytecodeCompiler. Non contiene puntatori, cosi'
+// che le sue parti si possano copiare cosi' come sono in un'immagine
+// (ProgramImage): i nomi delle variabili e i messaggi stanno in text.
+struct Bytecode {
+	// variabile o vettore, per i controlli dei limiti e per i messaggi
+	// degli errori di esecuzione
+	struct Variable {
+		std::uint32_t name;			// posizione del nome in text
+		std::uint32_t nameLength;
+		std::int32_t size;
+	};
+
+	// messaggio di un'istruzione ERROR
+	struct Message {
+		std::uint32_t offset;		// posizione in text
+		std::uint32_t length;
+	};
+
+	std::vector<Instruction> code;
+	std::vector<Variable> variables;
+	std::vector<Message> messages;
+	std::string text;
+	std::uint32_t frameSize = 0;
+	// profondita' massima della pila degli operandi
+	std::uint32_t stackSize = 0;
+};
+
+// Bytecode in memoria, senza possederlo: quello di un Bytecode o quello di
+// un'immagine mappata, che VirtualMachine esegue senza copiarlo
+struct BytecodeView {
+	const Instruction* code = nullptr;
+	const Bytecode::Variable* variables = nullptr;
+	const Bytecode::Message* messages = nullptr;
+	const char* text = nullptr;
+	std::uint32_t frameSize = 0;
+	std::uint32_t stackSize = 0;
+
+	BytecodeView() = default;
+	BytecodeView(const Bytecode& bytecode)
+		: code{ bytecode.code.data() }, variables{ bytecode.variables.data() },
+		messages{ bytecode.messages.data() }, text{ bytecode.text.data() },
+		frameSize{ bytecode.frameSize }, stackSize{ bytecode.stackSize } {}
+
+	std::string_view name(const Bytecode::Variable& variable) const {
+		return std::string_view{ text + variable.name, variable.nameLength };
+	}
+
+	std::string_view message(std::int32_t index) const {
+		return std::string_view{ text + messages[index].offset, messages[index].length };
+	}
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "BytecodeCompiler.h"
+
+#include <algorithm>
+
+#include "EvaluationVisitor.h"
+#include "Exceptions.h"
+
+namespace {
+
+	Decl* declaration(Id* id) {
+		Decl* decl = id->getDecl();
+		if (!decl)
+			throw EvaluationError{ "Name " + std::string{ id->getName() } + " not resolved" };
+		return decl;
+	}
+
+	bool isVector(Decl* decl) {
+		return decl->getType()->getKind() == NodeKind::VECTOR_TYPE;
+	}
+
+	std::uint32_t cellsOf(Decl* decl) {
+		if (isVector(decl))
+			return static_cast<std::uint32_t>(static_cast<vectorType*>(decl->getType())->getSize());
+		return 1;
+	}
+
+	// variazione dell'altezza della pila dopo op (per i salti condizionati,
+	// quando non saltano)
+	int stackEffect(OpCode op) {
+		switch (op) {
+		case OpCode::PUSH:
+		case OpCode::LOAD:
+			return 1;
+		case OpCode::STORE_ELEM:
+			return -2;
+		case OpCode::STORE:
+		case OpCode::ADD: case OpCode::SUB: case OpCode::MUL: case OpCode::DIV:
+		case OpCode::EQ: case OpCode::NOT_EQ:
+		case OpCode::MORE: case OpCode::MORE_EQ: case OpCode::LESS: case OpCode::LESS_EQ:
+		case OpCode::JUMP_IF_FALSE: case OpCode::JUMP_IF_TRUE:
+		case OpCode::JUMP_IF_FALSE_OR_POP: case OpCode::JUMP_IF_TRUE_OR_POP:
+		case OpCode::PRINT_INT: case OpCode::PRINT_BOOL:
+			return -1;
+		default:
+			return 0;
+		}
+	}
+
+	OpCode arithmOpCode(Op::BinOpCode op) {
+		switch (op) {
+		case Op::ADD: return OpCode::ADD;
+		case Op::SUB: return OpCode::SUB;
+		case Op::MUL: return OpCode::MUL;
+		case Op::DIV: return OpCode::DIV;
+		case Op::EQ: return OpCode::EQ;
+		default: return OpCode::NOT_EQ;
+		}
+	}
+
+	OpCode relOpCode(Rel::OpCode op) {
+		switch (op) {
+		case Rel::MORE: return OpCode::MORE;
+		case Rel::MORE_EQ: return OpCode::MORE_EQ;
+		case Rel::LESS: return OpCode::LESS;
+		default: return OpCode::LESS_EQ;
+		}
+	}
+
+}
+
+
+Bytecode BytecodeCompiler::compile(Program* program) {
+	bytecode = Bytecode{};
+	variables.clear();
+	breaks.clear();
+	depth = 0;
+
+	compileBlock(program->getBlock());
+	emit(OpCode::HALT);
+	bytecode.frameSize = program->getFrameSize();
+	return std::move(bytecode);
+}
+
+
+// Le variabili di un blocco occupano celle consecutive (Resolver), che
+// vengono rese non assegnate con un'unica istruzione
+void BytecodeCompiler::compileBlock(Block* block) {
+	if (block->getDecls() && block->getDecls()->getSize() > 0) {
+		std::uint32_t first = UINT32_MAX;
+		std::uint32_t last = 0;
+		for (Decl* decl : *block->getDecls()) {
+			const std::uint32_t slot = decl->getId()->getSlot();
+			first = std::min(first, slot);
+			last = std::max(last, slot + cellsOf(decl));
+		}
+		emit(OpCode::CLEAR, static_cast<std::int32_t>(first), last - first);
+	}
+
+	if (block->getStmts())
+		for (Stmt* stmt : *block->getStmts())
+			compileStmt(stmt);
+}
+
+
+void BytecodeCompiler::compileStmt(Stmt* stmt) {
+	switch (stmt->getKind()) {
+	case NodeKind::BLOCK:
+		compileBlock(static_cast<Block*>(stmt));
+		break;
+
+	case NodeKind::SET:
+	{
+		Set* setNode = static_cast<Set*>(stmt);
+		Id* id = setNode->getId();
+		Decl* decl = declaration(id);
+		if (isVector(decl)) {
+			error(EvaluationVisitor::vectorAssigned(id->getName()).what());
+			break;
+		}
+		const Type::TypeCode type = visit(setNode->getExp());
+		if (type != decl->getType()->getType())
+			error(EvaluationVisitor::wrongAssignment(type, decl->getType()->getType(), id->getName()).what());
+		emit(OpCode::STORE, static_cast<std::int32_t>(setNode->getSlot()));
+		break;
+	}
+
+	case NodeKind::SET_ELEM:
+	{
+		// l'indice viene controllato prima di calcolare il valore
+		SetElem* setElemNode = static_cast<SetElem*>(stmt);
+		Id* id = setElemNode->getId();
+		Decl* decl = declaration(id);
+		if (!isVector(decl)) {
+			error(EvaluationVisitor::notAVector(id->getName()).what());
+			break;
+		}
+		compileIndex(setElemNode->getIndex());
+		emit(OpCode::CHECK_INDEX, static_cast<std::int32_t>(setElemNode->getSlot()), variable(id));
+		const Type::TypeCode type = visit(setElemNode->getExp());
+		if (type != decl->getType()->getType())
+			error(EvaluationVisitor::wrongAssignment(type, decl->getType()->getType(), id->getName()).what());
+		emit(OpCode::STORE_ELEM, static_cast<std::int32_t>(setElemNode->getSlot()));
+		break;
+	}
+
+	case NodeKind::IF:
+	{
+		If* ifNode = static_cast<If*>(stmt);
+		compileCondition(ifNode->getCondition());
+		const std::size_t skip = emit(OpCode::JUMP_IF_FALSE);
+		compileStmt(ifNode->getStmt());
+		patch(skip);
+		break;
+	}
+
+	case NodeKind::ELSE:
+	{
+		Else* elseNode = static_cast<Else*>(stmt);
+		compileCondition(elseNode->getCondition());
+		const std::size_t toFalse = emit(OpCode::JUMP_IF_FALSE);
+		compileStmt(elseNode->getifTrueStmt());
+		const std::size_t toEnd = emit(OpCode::JUMP);
+		patch(toFalse);
+		compileStmt(elseNode->getifFalseStmt());
+		patch(toEnd);
+		break;
+	}
+
+	case NodeKind::WHILE:
+	{
+		While* whileNode = static_cast<While*>(stmt);
+		const std::size_t start = bytecode.code.size();
+		compileCondition(whileNode->getCondition());
+		const std::size_t exit = emit(OpCode::JUMP_IF_FALSE);
+		breaks.emplace_back();
+		compileStmt(whileNode->getStmt());
+		emit(OpCode::JUMP, static_cast<std::int32_t>(start));
+		patch(exit);
+		for (std::size_t jump : breaks.back())
+			patch(jump);
+		breaks.pop_back();
+		break;
+	}
+
+	case NodeKind::DO:
+	{
+		Do* doNode = static_cast<Do*>(stmt);
+		const std::size_t start = bytecode.code.size();
+		breaks.emplace_back();
+		compileStmt(doNode->getStmt());
+		compileCondition(doNode->getCondition());
+		emit(OpCode::JUMP_IF_TRUE, static_cast<std::int32_t>(start));
+		for (std::size_t jump : breaks.back())
+			patch(jump);
+		breaks.pop_back();
+		break;
+	}
+
+	case NodeKind::BREAK:
+		if (breaks.empty())
+			error(EvaluationVisitor::breakOutsideLoop().what());
+		else
+			breaks.back().push_back(emit(OpCode::JUMP));
+		break;
+
+	case NodeKind::PRINT:
+	{
+		const Type::TypeCode type = visit(static_cast<Print*>(stmt)->getExp());
+		emit(type == Type::BOOL ? OpCode::PRINT_BOOL : OpCode::PRINT_INT);
+		break;
+	}
+
+	default:
+		throw EvaluationError{ "compilation of a node that is not a statement" };
+	}
+}
+
+
+void BytecodeCompiler::compileCondition(Expression* exp) {
+	require(visit(exp), Type::BOOL, "condition");
+}
+
+
+void BytecodeCompiler::compileIndex(Expression* index) {
+	require(visit(index), Type::INT, "vector index");
+}
+
+
+std::size_t BytecodeCompiler::emit(OpCode op, std::int32_t arg, std::uint32_t aux) {
+	bytecode.code.push_back(Instruction{ op, aux, arg });
+	depth = static_cast<std::uint32_t>(static_cast<int>(depth) + stackEffect(op));
+	if (depth > bytecode.stackSize)
+		bytecode.stackSize = depth;
+	return bytecode.code.size() - 1;
+}
+
+
+void BytecodeCompiler::patch(std::size_t jump) {
+	bytecode.code[jump].arg = static_cast<std::int32_t>(bytecode.code.size());
+}
+
+
+void BytecodeCompiler::error(const std::string& message) {
+	bytecode.messages.push_back(Bytecode::Message{ static_cast<std::uint32_t>(bytecode.text.size()),
+		static_cast<std::uint32_t>(message.size()) });
+	bytecode.text += message;
+	emit(OpCode::ERROR, static_cast<std::int32_t>(bytecode.messages.size() - 1));
+}
+
+
+// Il messaggio e' quello di EvaluationVisitor per un valore del tipo trovato
+void BytecodeCompiler::require(Type::TypeCode found, Type::TypeCode expected, const char* context) {
+	if (found == expected)
+		return;
+	try {
+		if (expected == Type::INT)
+			EvaluationVisitor::integer(Value{ found, 0 }, context);
+		else
+			EvaluationVisitor::boolean(Value{ found, 0 }, context);
+	}
+	catch (EvaluationError const& ee) {
+		error(ee.what());
+	}
+}
+
+
+std::uint32_t BytecodeCompiler::variable(Id* id) {
+	Decl* decl = declaration(id);
+	auto found = variables.find(decl);
+	if (found != variables.end())
+		return found->second;
+	const std::uint32_t index = static_cast<std::uint32_t>(bytecode.variables.size());
+	const std::string_view name = id->getName();
+	bytecode.variables.push_back(Bytecode::Variable{ static_cast<std::uint32_t>(bytecode.text.size()),
+		static_cast<std::uint32_t>(name.size()), static_cast<std::int32_t>(cellsOf(decl)) });
+	bytecode.text += name;
+	variables.emplace(decl, index);
+	return index;
+}
+
+
+// Dopo un ERROR il codice non viene mai eseguito, ma ogni espressione
+// lascia comunque un valore sulla pila perche' l'altezza resti coerente
+Type::TypeCode BytecodeCompiler::visitId(Id* idNode) {
+	Decl* decl = declaration(idNode);
+	if (isVector(decl)) {
+		error(EvaluationVisitor::vectorUsedAsValue(idNode->getName()).what());
+		emit(OpCode::PUSH);
+	}
+	else
+		emit(OpCode::LOAD, static_cast<std::int32_t>(idNode->getSlot()), variable(idNode));
+	return decl->getType()->getType();
+}
+
+
+Type::TypeCode BytecodeCompiler::visitIntConstant(intConstant* numNode) {
+	emit(OpCode::PUSH, numNode->getValue());
+	return Type::INT;
+}
+
+
+Type::TypeCode BytecodeCompiler::visitBoolConstant(boolConstant* boolNode) {
+	emit(OpCode::PUSH, boolNode->getValue() ? 1 : 0);
+	return Type::BOOL;
+}
+
+
+// Il tipo del risultato (e l'eventuale errore di tipo) e' quello che la
+// semantica di EvaluationVisitor da' a operandi dei tipi trovati
+Type::TypeCode BytecodeCompiler::visitBinOp(Arithm* arithmNode) {
+	const Type::TypeCode left = visit(arithmNode->getLeftExp());
+	const Type::TypeCode right = visit(arithmNode->getRightExp());
+	Type::TypeCode result = (arithmNode->getOp() == Op::EQ || arithmNode->getOp() == Op::NOT_EQ) ? Type::BOOL : Type::INT;
+	try {
+		result = EvaluationVisitor::arithm(arithmNode->getOp(), Value{ left, 1 }, Value{ right, 1 }).type;
+	}
+	catch (EvaluationError const& ee) {
+		error(ee.what());
+	}
+	emit(arithmOpCode(arithmNode->getOp()));
+	return result;
+}
+
+
+Type::TypeCode BytecodeCompiler::visitUnaryOp(Unary* unaryNode) {
+	const Type::TypeCode operand = visit(unaryNode->getExp());
+	try {
+		EvaluationVisitor::unary(unaryNode->getOp(), Value{ operand, 0 });
+	}
+	catch (EvaluationError const& ee) {
+		error(ee.what());
+	}
+	emit(OpCode::NEG);
+	return Type::INT;
+}
+
+
+Type::TypeCode BytecodeCompiler::visitAccess(Access* accessNode) {
+	Id* id = accessNode->getId();
+	Decl* decl = declaration(id);
+	if (!isVector(decl)) {
+		error(EvaluationVisitor::notAVector(id->getName()).what());
+		emit(OpCode::PUSH);
+		return decl->getType()->getType();
+	}
+	compileIndex(accessNode->getIndex());
+	emit(OpCode::LOAD_ELEM, static_cast<std::int32_t>(accessNode->getSlot()), variable(id));
+	return decl->getType()->getType();
+}
+
+
+Type::TypeCode BytecodeCompiler::visitNot(Not* notNode) {
+	const Type::TypeCode operand = visit(notNode->getExp());
+	try {
+		EvaluationVisitor::logicalNot(Value{ operand, 0 });
+	}
+	catch (EvaluationError const& ee) {
+		error(ee.what());
+	}
+	emit(OpCode::NOT);
+	return Type::BOOL;
+}
+
+
+// Il secondo operando viene valutato solo se serve, come in EvaluationVisitor
+Type::TypeCode BytecodeCompiler::visitAnd(And* andNode) {
+	require(visit(andNode->getLeftExp()), Type::BOOL, "&&");
+	const std::size_t shortCircuit = emit(OpCode::JUMP_IF_FALSE_OR_POP);
+	require(visit(andNode->getRightExp()), Type::BOOL, "&&");
+	patch(shortCircuit);
+	return Type::BOOL;
+}
+
+
+Type::TypeCode BytecodeCompiler::visitOr(Or* orNode) {
+	require(visit(orNode->getLeftExp()), Type::BOOL, "||");
+	const std::size_t shortCircuit = emit(OpCode::JUMP_IF_TRUE_OR_POP);
+	require(visit(orNode->getRightExp()), Type::BOOL, "||");
+	patch(shortCircuit);
+	return Type::BOOL;
+}
+
+
+Type::TypeCode BytecodeCompiler::visitRel(Rel* relNode) {
+	const Type::TypeCode left = visit(relNode->getLeftExp());
+	const Type::TypeCode right = visit(relNode->getRightExp());
+	try {
+		EvaluationVisitor::rel(relNode->getOp(), Value{ left, 0 }, Value{ right, 0 });
+	}
+	catch (EvaluationError const& ee) {
+		error(ee.what());
+	}
+	emit(relOpCode(relNode->getOp()));
+	return Type::BOOL;
+}
@@ -0,0 +1,65 @@
+#ifndef BYTECODE_COMPILER_H
+#define BYTECODE_COMPILER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Bytecode.h"
+#include "Node.h"
+#include "Visitor.h"
+
+// Traduzione del programma in Bytecode per VirtualMachine. I nomi devono
+// essere gia' stati risolti da Resolver: le celle del frame sono le stesse
+// di EvaluationVisitor. La visita di un'espressione emette il codice che ne
+// lascia il valore sulla pila e restituisce il suo tipo. Gli errori di tipo
+// (e i break fuori da un ciclo) non fermano la compilazione: diventano
+// un'istruzione ERROR nel punto in cui EvaluationVisitor li segnalerebbe,
+// con lo stesso messaggio, cosi' che le due esecuzioni producano la stessa
+// uscita.
+class BytecodeCompiler final : public ResultVisitor<Type::TypeCode> {
+
+public:
+	BytecodeCompiler() = default;
+	BytecodeCompiler(BytecodeCompiler const&) = delete;
+	BytecodeCompiler& operator=(BytecodeCompiler const&) = delete;
+
+	Bytecode compile(Program* program);
+
+	Type::TypeCode visitId(Id* idNode) override;
+	Type::TypeCode visitIntConstant(intConstant* numNode) override;
+	Type::TypeCode visitBoolConstant(boolConstant* boolNode) override;
+	Type::TypeCode visitBinOp(Arithm* arithmNode) override;
+	Type::TypeCode visitUnaryOp(Unary* unaryNode) override;
+	Type::TypeCode visitAccess(Access* accessNode) override;
+	Type::TypeCode visitNot(Not* notNode) override;
+	Type::TypeCode visitAnd(And* andNode) override;
+	Type::TypeCode visitOr(Or* orNode) override;
+	Type::TypeCode visitRel(Rel* relNode) override;
+
+private:
+	void compileStmt(Stmt* stmt);
+	void compileBlock(Block* block);
+	void compileCondition(Expression* exp);
+	// indice di un vettore, di cui viene controllato il tipo
+	void compileIndex(Expression* index);
+
+	std::size_t emit(OpCode op, std::int32_t arg = 0, std::uint32_t aux = 0);
+	// fa saltare l'istruzione jump alla prossima istruzione emessa
+	void patch(std::size_t jump);
+	void error(const std::string& message);
+	// emette ERROR se found non e' expected
+	void require(Type::TypeCode found, Type::TypeCode expected, const char* context);
+
+	// posizione della variabile id in Bytecode::variables
+	std::uint32_t variable(Id* id);
+
+	Bytecode bytecode;
+	std::unordered_map<Decl*, std::uint32_t> variables;
+	// per ogni ciclo aperto, i salti dei suoi break
+	std::vector<std::vector<std::size_t>> breaks;
+	std::uint32_t depth = 0;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "CompactAst.h"
+
+#include "Node.h"
+
+namespace {
+
+	// Stampa con le stesse parentesi e gli stessi separatori di PrintVisitor
+	class Printer : public CompactAst::Visitor {
+
+	public:
+		using NodeId = CompactAst::NodeId;
+
+		Printer(const CompactAst& tree, std::ostream& os) : ast{ tree }, out{ os } {}
+
+		void visitProgram(NodeId program) override {
+			out << "Program(";
+			visit(ast.a(program));
+			out << ")";
+		}
+
+		void visitBlock(NodeId block) override {
+			out << "Block(";
+			list(ast.decls(block), "Decls(");
+			out << ", ";
+			list(ast.stmts(block), "Stmts(");
+			out << ")";
+		}
+
+		void visitDecl(NodeId decl) override {
+			out << "Decl(";
+			if (ast.kind(decl) == CompactAst::VECTOR_DECL)
+				out << "VectorType(" << Type::typeid2String[ast.code(decl)]
+					<< ", [" << static_cast<int>(ast.b(decl)) << "]" << ")";
+			else
+				out << "Type(" << Type::typeid2String[ast.code(decl)] << ")";
+			out << ", ";
+			visit(ast.a(decl));
+			out << ")";
+		}
+
+		void visitId(NodeId id) override {
+			out << "Id(" << ast.name(id) << ")";
+		}
+
+		void visitIf(NodeId ifNode) override { binary("If(", ifNode, ", "); }
+		void visitWhile(NodeId whileNode) override { binary("While(", whileNode, ", "); }
+		void visitDo(NodeId doNode) override { binary("Do(", doNode, ", "); }
+		void visitSet(NodeId setNode) override { binary("Set(", setNode, ", "); }
+		void visitAnd(NodeId andNode) override { binary("And(", andNode, ", "); }
+		void visitOr(NodeId orNode) override { binary("Or(", orNode, ", "); }
+
+		void visitElse(NodeId elseNode) override {
+			out << "Else(";
+			visit(ast.a(elseNode));
+			out << ", ";
+			visit(ast.b(elseNode));
+			out << ", ";
+			visit(ast.c(elseNode));
+			out << ")";
+		}
+
+		void visitSetElem(NodeId setElemNode) override {
+			out << "SetElem(";
+			visit(ast.a(setElemNode));
+			out << ",[";
+			visit(ast.b(setElemNode));
+			out << "], ";
+			visit(ast.c(setElemNode));
+			out << ")";
+		}
+
+		void visitBreak(NodeId) override {
+			out << "Break()";
+		}
+
+		void visitPrint(NodeId printNode) override {
+			out << "Print(";
+			visit(ast.a(printNode));
+			out << ")";
+		}
+
+		void visitIntConstant(NodeId numNode) override {
+			out << "IntConstant(" << ast.intValue(numNode) << ")";
+		}
+
+		void visitBoolConstant(NodeId boolNode) override {
+			out << "BoolConstant(" << (ast.a(boolNode) != 0) << ")";
+		}
+
+		void visitNot(NodeId notNode) override {
+			out << "Not(";
+			visit(ast.a(notNode));
+			out << ")";
+		}
+
+		void visitRel(NodeId relNode) override {
+			out << "Rel(" << Rel::opCode2String[ast.code(relNode)] << ", ";
+			binary("", relNode, ", ");
+		}
+
+		void visitBinOp(NodeId arithmNode) override {
+			out << "Arithm(" << Op::binOp2String[ast.code(arithmNode)] << ", ";
+			binary("", arithmNode, ", ");
+		}
+
+		void visitUnaryOp(NodeId unaryNode) override {
+			out << "Unary(" << Op::unaryOp2String[ast.code(unaryNode)] << ", ";
+			visit(ast.a(unaryNode));
+			out << ")";
+		}
+
+		void visitAccess(NodeId accessNode) override {
+			out << "Access(";
+			visit(ast.a(accessNode));
+			out << ",[";
+			visit(ast.b(accessNode));
+			out << ",] )";
+		}
+
+		void visit(NodeId n) {
+			ast.accept(n, *this);
+		}
+
+	private:
+		const CompactAst& ast;
+		std::ostream& out;
+
+		// open + a + separator + b + ")"
+		void binary(const char* open, NodeId n, const char* separator) {
+			out << open;
+			visit(ast.a(n));
+			out << separator;
+			visit(ast.b(n));
+			out << ")";
+		}
+
+		// forma annidata List(x1, List(x2, NULL)); NULL se la lista e' vuota
+		void list(CompactAst::Range items, const char* open) {
+			for (NodeId item : items) {
+				out << open;
+				visit(item);
+				out << ", ";
+			}
+			out << "NULL";
+			for (std::size_t i = 0; i < items.size(); ++i)
+				out << ")";
+		}
+	};
+
+}
+
+
+void CompactAst::accept(NodeId n, Visitor& v) const {
+	switch (kind(n)) {
+	case PROGRAM: v.visitProgram(n); break;
+	case BLOCK: v.visitBlock(n); break;
+	case DECL:
+	case VECTOR_DECL: v.visitDecl(n); break;
+	case ID: v.visitId(n); break;
+	case IF: v.visitIf(n); break;
+	case ELSE: v.visitElse(n); break;
+	case WHILE: v.visitWhile(n); break;
+	case DO: v.visitDo(n); break;
+	case SET: v.visitSet(n); break;
+	case SET_ELEM: v.visitSetElem(n); break;
+	case BREAK: v.visitBreak(n); break;
+	case PRINT: v.visitPrint(n); break;
+	case INT_CONSTANT: v.visitIntConstant(n); break;
+	case BOOL_CONSTANT: v.visitBoolConstant(n); break;
+	case NOT: v.visitNot(n); break;
+	case AND: v.visitAnd(n); break;
+	case OR: v.visitOr(n); break;
+	case REL: v.visitRel(n); break;
+	case ARITHM: v.visitBinOp(n); break;
+	case UNARY: v.visitUnaryOp(n); break;
+	case ACCESS: v.visitAccess(n); break;
+	}
+}
+
+
+std::size_t CompactAst::bytes() const {
+	return kinds.size() * (2 * sizeof(std::uint8_t) + 3 * sizeof(std::uint32_t))
+		+ children.size() * sizeof(NodeId);
+}
+
+
+CompactAst::NodeId CompactAst::add(Kind kind, std::uint8_t code,
+	std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+
+	NodeId n = static_cast<NodeId>(kinds.size());
+	kinds.push_back(kind);
+	codes.push_back(code);
+	as.push_back(a);
+	bs.push_back(b);
+	cs.push_back(c);
+	return n;
+}
+
+
+CompactAst::NodeId CompactAst::addBlock(const NodeId* decls, std::size_t declCount,
+	const NodeId* stmts, std::size_t stmtCount) {
+
+	std::uint32_t first = static_cast<std::uint32_t>(children.size());
+	children.insert(children.end(), decls, decls + declCount);
+	children.insert(children.end(), stmts, stmts + stmtCount);
+	return add(BLOCK, 0, first, static_cast<std::uint32_t>(declCount), static_cast<std::uint32_t>(stmtCount));
+}
+
+
+void CompactAst::reserve(std::size_t nodes) {
+	kinds.reserve(nodes);
+	codes.reserve(nodes);
+	as.reserve(nodes);
+	bs.reserve(nodes);
+	cs.reserve(nodes);
+}
+
+
+void CompactAst::clear() {
+	kinds.clear();
+	codes.clear();
+	as.clear();
+	bs.clear();
+	cs.clear();
+	children.clear();
+	rootNode = NONE;
+}
+
+
+void print(const CompactAst& ast, std::ostream& out) {
+	Printer{ ast, out }.visit(ast.root());
+}
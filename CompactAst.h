@@ -0,0 +1,170 @@
+#ifndef COMPACT_AST_H
+#define COMPACT_AST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "Atoms.h"
+
+// Codifica compatta dell'AST, alternativa alla gerarchia di Node: i nodi
+// non sono oggetti ma indici a 32 bit in array paralleli (una colonna per
+// il tipo di nodo, una per il codice dell'operatore e tre per i figli o i
+// valori), senza vtable ne' puntatori. I figli dei blocchi stanno in un
+// array di indici e i nomi degli identificatori sono atomi (AtomTable).
+// La costruisce direttamente CompactParser; i nodi vengono aggiunti in
+// ordine posticipato, quindi ogni nodo segue i suoi figli e la radice
+// (PROGRAM) e' l'ultimo.
+class CompactAst {
+
+public:
+	using NodeId = std::uint32_t;
+
+	// figlio assente
+	static constexpr NodeId NONE = UINT32_MAX;
+
+	enum Kind : std::uint8_t {
+		PROGRAM,		// a: blocco
+		BLOCK,			// a: prima dichiarazione in children, b: dichiarazioni, c: statement (dopo le dichiarazioni)
+		DECL,			// code: Type::TypeCode, a: identificatore
+		VECTOR_DECL,	// code: Type::TypeCode, a: identificatore, b: dimensione
+		ID,				// a: atomo del nome
+		IF,				// a: condizione, b: statement
+		ELSE,			// a: condizione, b: ramo vero, c: ramo falso
+		WHILE,			// a: condizione, b: statement
+		DO,				// a: condizione, b: statement
+		SET,			// a: identificatore, b: espressione
+		SET_ELEM,		// a: identificatore, b: indice, c: espressione
+		BREAK,
+		PRINT,			// a: espressione
+		INT_CONSTANT,	// a: valore
+		BOOL_CONSTANT,	// a: valore
+		NOT,			// a: espressione
+		AND,			// a, b: operandi
+		OR,				// a, b: operandi
+		REL,			// code: Rel::OpCode, a, b: operandi
+		ARITHM,			// code: Op::BinOpCode, a, b: operandi
+		UNARY,			// code: Op::UnaryOpCode, a: operando
+		ACCESS			// a: identificatore, b: indice
+	};
+
+	// Intervallo di indici di nodi (dichiarazioni o statement di un blocco)
+	struct Range {
+		const NodeId* first;
+		const NodeId* last;
+		const NodeId* begin() const { return first; }
+		const NodeId* end() const { return last; }
+		std::size_t size() const { return last - first; }
+		bool empty() const { return first == last; }
+	};
+
+	// Visitor sui nodi compatti: CompactAst::accept sceglie il metodo con
+	// uno switch sul tipo del nodo
+	class Visitor {
+	public:
+		virtual ~Visitor() = default;
+		virtual void visitProgram(NodeId program) = 0;
+		virtual void visitBlock(NodeId block) = 0;
+		virtual void visitDecl(NodeId decl) = 0;
+		virtual void visitId(NodeId id) = 0;
+		virtual void visitIf(NodeId ifNode) = 0;
+		virtual void visitElse(NodeId elseNode) = 0;
+		virtual void visitWhile(NodeId whileNode) = 0;
+		virtual void visitDo(NodeId doNode) = 0;
+		virtual void visitSet(NodeId setNode) = 0;
+		virtual void visitSetElem(NodeId setElemNode) = 0;
+		virtual void visitBreak(NodeId breakNode) = 0;
+		virtual void visitPrint(NodeId printNode) = 0;
+		virtual void visitIntConstant(NodeId numNode) = 0;
+		virtual void visitBoolConstant(NodeId boolNode) = 0;
+		virtual void visitNot(NodeId notNode) = 0;
+		virtual void visitAnd(NodeId andNode) = 0;
+		virtual void visitOr(NodeId orNode) = 0;
+		virtual void visitRel(NodeId relNode) = 0;
+		virtual void visitBinOp(NodeId arithmNode) = 0;
+		virtual void visitUnaryOp(NodeId unaryNode) = 0;
+		virtual void visitAccess(NodeId accessNode) = 0;
+	};
+
+	CompactAst() = default;
+
+	std::size_t size() const { return kinds.size(); }
+	NodeId root() const { return rootNode; }
+
+	Kind kind(NodeId n) const { return static_cast<Kind>(kinds[n]); }
+	std::uint8_t code(NodeId n) const { return codes[n]; }
+	std::uint32_t a(NodeId n) const { return as[n]; }
+	std::uint32_t b(NodeId n) const { return bs[n]; }
+	std::uint32_t c(NodeId n) const { return cs[n]; }
+
+	Range decls(NodeId block) const {
+		const NodeId* first = children.data() + as[block];
+		return Range{ first, first + bs[block] };
+	}
+	Range stmts(NodeId block) const {
+		const NodeId* first = children.data() + as[block] + bs[block];
+		return Range{ first, first + cs[block] };
+	}
+	Atom atom(NodeId id) const { return as[id]; }
+	std::string_view name(NodeId id) const { return AtomTable::global().spelling(as[id]); }
+	int intValue(NodeId constant) const { return static_cast<int>(as[constant]); }
+
+	void accept(NodeId n, Visitor& v) const;
+
+	// Chiama f(figlio) per ogni figlio di n, nell'ordine del sorgente
+	template <typename F>
+	void forEachChild(NodeId n, F f) const {
+		switch (kind(n)) {
+		case BLOCK:
+			for (NodeId child : decls(n))
+				f(child);
+			for (NodeId child : stmts(n))
+				f(child);
+			break;
+		case PROGRAM: case DECL: case VECTOR_DECL: case PRINT: case NOT: case UNARY:
+			f(as[n]);
+			break;
+		case IF: case WHILE: case DO: case SET: case AND: case OR: case REL: case ARITHM: case ACCESS:
+			f(as[n]);
+			f(bs[n]);
+			break;
+		case ELSE: case SET_ELEM:
+			f(as[n]);
+			f(bs[n]);
+			f(cs[n]);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Byte occupati dalle colonne e dai figli dei blocchi
+	std::size_t bytes() const;
+
+	// Costruzione (usata da CompactParser)
+	NodeId add(Kind kind, std::uint8_t code = 0,
+		std::uint32_t a = NONE, std::uint32_t b = NONE, std::uint32_t c = NONE);
+	NodeId addBlock(const NodeId* decls, std::size_t declCount,
+		const NodeId* stmts, std::size_t stmtCount);
+	NodeId addId(Atom name) { return add(ID, 0, name); }
+	void setRoot(NodeId program) { rootNode = program; }
+	void reserve(std::size_t nodes);
+	void clear();
+
+private:
+	std::vector<std::uint8_t> kinds;
+	std::vector<std::uint8_t> codes;
+	std::vector<std::uint32_t> as;
+	std::vector<std::uint32_t> bs;
+	std::vector<std::uint32_t> cs;
+
+	std::vector<NodeId> children;
+	NodeId rootNode = NONE;
+};
+
+// Stampa l'AST compatto nella stessa forma di PrintVisitor
+void print(const CompactAst& ast, std::ostream& out);
+
+#endif
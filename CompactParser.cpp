@@ -0,0 +1,256 @@
+#include "CompactParser.h"
+
+#include <string>
+
+#include "BinaryOperators.h"
+#include "Node.h"
+
+using namespace BinaryOperators;
+
+
+// Ogni nodo, tranne PROGRAM, consuma almeno un token: il numero dei token
+// basta per non dover mai ingrandire le colonne
+CompactAst::NodeId CompactParser::operator()() {
+	ast.reserve(ast.size() + stream.size() + 1);
+	NodeId program = ast.add(CompactAst::PROGRAM, 0, parseBlock());
+	if (tokenItr->tag != Token::END_OF_INPUT)
+		throw ParseError("Unexpected end of input");
+	ast.setRoot(program);
+	return program;
+}
+
+
+// Le dichiarazioni e poi gli statement si accumulano su scratch sopra mark;
+// i blocchi annidati tornano a mark prima che si prosegua
+CompactAst::NodeId CompactParser::parseBlock() {
+	consumeToken(Token::LEFT_CURLY);
+	const std::size_t mark = scratch.size();
+	while (tokenItr->tag == Token::BOOL || tokenItr->tag == Token::INT)
+		scratch.push_back(parseDecl());
+	const std::size_t declCount = scratch.size() - mark;
+	while (tokenItr->tag != Token::RIGHT_CURLY)
+	{
+		NodeId stmt = parseStmt();
+		scratch.push_back(stmt);
+	}
+	consumeToken(Token::RIGHT_CURLY);
+
+	NodeId block = ast.addBlock(scratch.data() + mark, declCount,
+		scratch.data() + mark + declCount, scratch.size() - mark - declCount);
+	scratch.resize(mark);
+	return block;
+}
+
+
+CompactAst::NodeId CompactParser::parseDecl() {
+	Type::TypeCode typeCode;
+	switch (tokenItr->tag) {
+	case Token::INT:
+		typeCode = Type::INT;
+		break;
+	case Token::BOOL:
+		typeCode = Type::BOOL;
+		break;
+	default:
+		throw ParseError{ "basic type expected and not found" };
+	}
+	safe_next();
+
+	std::uint32_t size = CompactAst::NONE;
+	if (tokenItr->tag == Token::LEFT_SQUARE) {
+		safe_next();
+		if (tokenItr->tag != Token::NUM)
+			throw ParseError{ "Expected numeric constant, not found" };
+		size = static_cast<std::uint32_t>(tokenItr->value);
+		safe_next();
+		consumeToken(Token::RIGHT_SQUARE);
+	}
+
+	NodeId id = parseId();
+	consumeToken(Token::END_STMT);
+	if (size == CompactAst::NONE)
+		return ast.add(CompactAst::DECL, static_cast<std::uint8_t>(typeCode), id);
+	return ast.add(CompactAst::VECTOR_DECL, static_cast<std::uint8_t>(typeCode), id, size);
+}
+
+
+CompactAst::NodeId CompactParser::parseId() {
+	if (tokenItr->tag != Token::ID)
+		throw ParseError{ "Expected identifier, not found" };
+	NodeId id = ast.addId(static_cast<Atom>(tokenItr->value));
+	safe_next();
+	return id;
+}
+
+
+CompactAst::NodeId CompactParser::parseStmt() {
+	switch (tokenItr->tag) {
+	case Token::ID:
+	{
+		NodeId id = parseId();
+		if (tokenItr->tag == Token::LEFT_SQUARE) {
+			safe_next();
+			NodeId index = parseExpression();
+			consumeToken(Token::RIGHT_SQUARE);
+			consumeToken(Token::ASSIGN);
+			NodeId expr = parseExpression();
+			consumeToken(Token::END_STMT);
+			return ast.add(CompactAst::SET_ELEM, 0, id, index, expr);
+		}
+		consumeToken(Token::ASSIGN);
+		NodeId expr = parseExpression();
+		consumeToken(Token::END_STMT);
+		return ast.add(CompactAst::SET, 0, id, expr);
+	}
+
+	case Token::IF:
+	{
+		safe_next();
+		consumeToken(Token::LP);
+		NodeId condition = parseExpression();
+		consumeToken(Token::RP);
+		NodeId ifTrueStmt = parseStmt();
+		if (tokenItr->tag == Token::ELSE) {
+			safe_next();
+			NodeId ifFalseStmt = parseStmt();
+			return ast.add(CompactAst::ELSE, 0, condition, ifTrueStmt, ifFalseStmt);
+		}
+		return ast.add(CompactAst::IF, 0, condition, ifTrueStmt);
+	}
+
+	case Token::WHILE:
+	{
+		safe_next();
+		consumeToken(Token::LP);
+		NodeId condition = parseExpression();
+		consumeToken(Token::RP);
+		NodeId stmt = parseStmt();
+		return ast.add(CompactAst::WHILE, 0, condition, stmt);
+	}
+
+	case Token::DO:
+	{
+		safe_next();
+		NodeId stmt = parseStmt();
+		consumeToken(Token::WHILE);
+		consumeToken(Token::LP);
+		NodeId condition = parseExpression();
+		consumeToken(Token::RP);
+		consumeToken(Token::END_STMT);
+		return ast.add(CompactAst::DO, 0, condition, stmt);
+	}
+
+	case Token::BREAK:
+		safe_next();
+		consumeToken(Token::END_STMT);
+		return ast.add(CompactAst::BREAK);
+
+	case Token::PRINT:
+	{
+		safe_next();
+		consumeToken(Token::LP);
+		NodeId exprToPrint = parseExpression();
+		consumeToken(Token::RP);
+		consumeToken(Token::END_STMT);
+		return ast.add(CompactAst::PRINT, 0, exprToPrint);
+	}
+
+	case Token::LEFT_CURLY:
+		return parseBlock();
+
+	default:
+		throw ParseError("No valid symbol at start of Stmt Parsing");
+	}
+}
+
+
+// Precedence climbing con la tabella di BinaryOperators.h, come in Parser
+CompactAst::NodeId CompactParser::parseExpression(int minPrecedence) {
+	NodeId exp = parseUnaryOp();
+	int expPrecedence = PRIMARY_PRECEDENCE;
+
+	for (;;) {
+		const BinaryOperator& op = binaryOperators[tokenItr->tag];
+		if (op.precedence < minPrecedence)
+			break;
+		if (op.kind == BinaryKind::REL && expPrecedence <= op.precedence)
+			break;
+
+		safe_next();
+		NodeId right = parseExpression(op.precedence + 1);
+
+		switch (op.kind) {
+		case BinaryKind::OR:
+			exp = ast.add(CompactAst::OR, 0, exp, right);
+			break;
+		case BinaryKind::AND:
+			exp = ast.add(CompactAst::AND, 0, exp, right);
+			break;
+		case BinaryKind::REL:
+			exp = ast.add(CompactAst::REL, static_cast<std::uint8_t>(op.code), exp, right);
+			break;
+		default:
+			exp = ast.add(CompactAst::ARITHM, static_cast<std::uint8_t>(op.code), exp, right);
+			break;
+		}
+		expPrecedence = op.precedence;
+	}
+	return exp;
+}
+
+
+CompactAst::NodeId CompactParser::parseUnaryOp() {
+	switch (tokenItr->tag) {
+	case Token::NOT:
+		safe_next();
+		return ast.add(CompactAst::NOT, 0, parseUnaryOp());
+	case Token::MIN:
+		safe_next();
+		return ast.add(CompactAst::UNARY, Op::UNARY_MIN, parseUnaryOp());
+	default:
+		return parseFactor();
+	}
+}
+
+
+CompactAst::NodeId CompactParser::parseFactor() {
+	switch (tokenItr->tag) {
+	case Token::LP:
+	{
+		safe_next();
+		NodeId exp = parseExpression();
+		consumeToken(Token::RP);
+		return exp;
+	}
+
+	case Token::ID:
+	{
+		NodeId id = parseId();
+		if (tokenItr->tag == Token::LEFT_SQUARE) {
+			safe_next();
+			NodeId index = parseExpression();
+			consumeToken(Token::RIGHT_SQUARE);
+			return ast.add(CompactAst::ACCESS, 0, id, index);
+		}
+		return id;
+	}
+
+	case Token::NUM:
+	{
+		std::uint32_t value = static_cast<std::uint32_t>(tokenItr->value);
+		safe_next();
+		return ast.add(CompactAst::INT_CONSTANT, 0, value);
+	}
+
+	case Token::TRUE:
+	case Token::FALSE:
+	{
+		std::uint32_t value = tokenItr->tag == Token::TRUE;
+		safe_next();
+		return ast.add(CompactAst::BOOL_CONSTANT, 0, value);
+	}
+
+	default:
+		throw ParseError("Error while parsing factor " + std::to_string(tokenItr->tag));
+	}
+}
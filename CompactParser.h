@@ -0,0 +1,65 @@
+#ifndef COMPACT_PARSER_H
+#define COMPACT_PARSER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CompactAst.h"
+#include "Exceptions.h"
+#include "Token.h"
+#include "TokenStream.h"
+
+// Parser che costruisce direttamente un CompactAst, senza passare dai Node.
+// La grammatica (e gli errori segnalati) sono gli stessi di Parser nel modo
+// STRICT; i token devono essere tutti in memoria in un TokenStream.
+class CompactParser {
+
+public:
+	CompactParser(CompactAst& tree, const TokenStream& tokens)
+	 : ast{ tree }, stream{ tokens }, tokenItr{ tokens.getTokens().data() } {}
+
+	CompactParser(CompactParser const&) = delete;
+	CompactParser& operator=(CompactParser const&) = delete;
+
+	// Analizza il programma, lo aggiunge all'AST e ne restituisce la radice
+	CompactAst::NodeId operator()();
+
+private:
+	using NodeId = CompactAst::NodeId;
+
+	CompactAst& ast;
+	const TokenStream& stream;
+	const Token* tokenItr;
+
+	// Elementi delle liste dei blocchi aperti, come stmtScratch in Parser:
+	// un blocco annidato lavora sopra gli elementi del blocco che lo contiene
+	std::vector<NodeId> scratch;
+
+	NodeId parseBlock();
+	NodeId parseDecl();
+	NodeId parseId();
+	NodeId parseStmt();
+	NodeId parseExpression(int minPrecedence = 1);
+	NodeId parseUnaryOp();
+	NodeId parseFactor();
+
+	void safe_next() {
+		if (tokenItr->tag == Token::END_OF_INPUT)
+			throw ParseError("Unexpected end of input");
+		++tokenItr;
+	}
+
+	void consumeToken(const int tokenId) {
+		if (tokenItr->tag == tokenId)
+			safe_next();
+		else
+			throw ParseError{
+			std::string("Expecting ").
+			append(Token::id2word[tokenId]).
+			append(", instead found ").
+			append(Token::id2word[tokenItr->tag]) };
+	}
+};
+
+#endif
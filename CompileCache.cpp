@@ -0,0 +1,125 @@
+#include "CompileCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+
+	inline std::uint64_t mix(std::uint64_t h) {
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+}
+
+
+CompileCache::CompileCache(std::string dir) : directory{ std::move(dir) } {
+}
+
+
+// Hash a parole di 8 byte (la coda viene completata con zeri), con
+// rimescolamento finale
+std::uint64_t CompileCache::hash(const char* data, std::size_t size) {
+	std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+	std::size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		h = (h ^ word) * 0x100000001b3ULL;
+		h = (h << 31) | (h >> 33);
+	}
+	std::uint64_t tail = 0;
+	std::memcpy(&tail, data + i, size - i);
+	h = (h ^ tail) * 0x100000001b3ULL;
+	return mix(h);
+}
+
+
+// La versione del compilatore e' il contenuto dell'eseguibile, che cambia
+// ricompilando uno qualunque dei sorgenti, anche senza ricompilare questo
+// file. La build puo' aggiungere COMPILER_VERSION (per esempio l'hash del
+// commit), che basta dove l'eseguibile non si puo' leggere; senza nessuno
+// dei due il risultato e' 0 e la cache non viene usata.
+std::uint64_t CompileCache::compilerHash() {
+	static const std::uint64_t version = [] {
+		std::uint64_t h = 0;
+#ifdef __linux__
+		try {
+			SourceBuffer executable{ "/proc/self/exe" };
+			h = hash(executable.data(), executable.size());
+		}
+		catch (std::exception const&) {
+		}
+#endif
+#ifdef COMPILER_VERSION
+		constexpr char buildVersion[] = COMPILER_VERSION;
+		h = mix(h ^ hash(buildVersion, sizeof buildVersion - 1));
+#endif
+		return h == 0 ? 0 : h ^ ProgramImage::formatVersion;
+	}();
+	return version;
+}
+
+
+std::string CompileCache::pathFor(std::uint64_t sourceHash) const {
+	char name[32];
+	std::snprintf(name, sizeof name, "%016llx.img",
+		static_cast<unsigned long long>(sourceHash ^ compilerHash()));
+	return (std::filesystem::path(directory) / name).string();
+}
+
+
+bool CompileCache::lookup(std::uint64_t sourceHash, std::size_t sourceSize, Entry& entry) const {
+	if (compilerHash() == 0)
+		return false;
+	std::string path = pathFor(sourceHash);
+	std::error_code ec;
+	if (!std::filesystem::is_regular_file(path, ec))
+		return false;
+	try {
+		entry.mapping = SourceBuffer{ path };
+	}
+	catch (std::exception const&) {
+		return false;
+	}
+	return entry.image.open(entry.mapping.data(), entry.mapping.size(), compilerHash(),
+		sourceHash, sourceSize);
+}
+
+
+bool CompileCache::store(std::uint64_t sourceHash, const std::string& image) const {
+	if (compilerHash() == 0)
+		return false;
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+	if (ec)
+		return false;
+
+	// il file temporaneo ha un nome diverso per ogni processo che scrive
+	std::string path = pathFor(sourceHash);
+	std::string temporary = path + "." + std::to_string(std::random_device{}()) + ".tmp";
+	bool written = false;
+	{
+		std::ofstream out(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write(image.data(), static_cast<std::streamsize>(image.size()));
+		out.close();
+		written = !out.fail();
+	}
+	if (written)
+		std::filesystem::rename(temporary, path, ec);
+
+	// dopo un errore (per esempio il disco pieno) il file temporaneo non
+	// deve restare nella directory
+	if (!written || ec) {
+		std::filesystem::remove(temporary, ec);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,46 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "ProgramImage.h"
+#include "SourceBuffer.h"
+
+// Cache su disco dei programmi gia' analizzati. Ogni voce e' l'immagine
+// binaria (ProgramImage) di un sorgente, in un file il cui nome deriva
+// dall'hash del contenuto del sorgente e della versione del compilatore:
+// un sorgente modificato o un compilatore ricompilato non trovano voci
+// vecchie. Le immagini vengono mappate in memoria e usate direttamente.
+class CompileCache {
+
+public:
+	explicit CompileCache(std::string directory);
+
+	// Hash del contenuto di un sorgente
+	static std::uint64_t hash(const char* data, std::size_t size);
+
+	// Hash della versione del compilatore (il contenuto dell'eseguibile);
+	// 0 se non e' determinabile, e allora la cache resta vuota
+	static std::uint64_t compilerHash();
+
+	// Voce della cache per il sorgente con hash sourceHash: se esiste ed e'
+	// valida, image e' pronta all'uso finche' l'Entry e' viva
+	struct Entry {
+		SourceBuffer mapping = SourceBuffer::fromMemory({});
+		ProgramImage::View image;
+	};
+	bool lookup(std::uint64_t sourceHash, std::size_t sourceSize, Entry& entry) const;
+
+	// Salva l'immagine di un sorgente (scrivendo un file temporaneo e poi
+	// rinominandolo, cosi' nessuno legge un'immagine scritta a meta').
+	// Restituisce false se non e' stato possibile.
+	bool store(std::uint64_t sourceHash, const std::string& image) const;
+
+private:
+	std::string pathFor(std::uint64_t sourceHash) const;
+
+	std::string directory;
+};
+
+#endif
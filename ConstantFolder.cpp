@@ -0,0 +1,193 @@
+#include "ConstantFolder.h"
+
+#include "EvaluationVisitor.h"
+
+namespace {
+
+	bool isConstant(Expression* exp) {
+		return exp->getKind() == NodeKind::INT_CONSTANT || exp->getKind() == NodeKind::BOOL_CONSTANT;
+	}
+
+	Value valueOf(Expression* constant) {
+		if (constant->getKind() == NodeKind::INT_CONSTANT)
+			return Value::ofInt(static_cast<intConstant*>(constant)->getValue());
+		return Value::ofBool(static_cast<boolConstant*>(constant)->getValue());
+	}
+
+}
+
+
+void ConstantFolder::fold(Program* program) {
+	foldStmt(program->getBlock());
+}
+
+
+void ConstantFolder::foldStmt(Stmt* stmt) {
+	switch (stmt->getKind()) {
+	case NodeKind::BLOCK:
+	{
+		Block* block = static_cast<Block*>(stmt);
+		if (block->getStmts())
+			for (Stmt* child : *block->getStmts())
+				foldStmt(child);
+		break;
+	}
+	case NodeKind::SET:
+	{
+		Set* setNode = static_cast<Set*>(stmt);
+		setNode->setExp(visit(setNode->getExp()));
+		break;
+	}
+	case NodeKind::SET_ELEM:
+	{
+		SetElem* setElemNode = static_cast<SetElem*>(stmt);
+		setElemNode->setIndex(visit(setElemNode->getIndex()));
+		setElemNode->setExp(visit(setElemNode->getExp()));
+		break;
+	}
+	case NodeKind::IF:
+	{
+		If* ifNode = static_cast<If*>(stmt);
+		ifNode->setCondition(visit(ifNode->getCondition()));
+		foldStmt(ifNode->getStmt());
+		break;
+	}
+	case NodeKind::ELSE:
+	{
+		Else* elseNode = static_cast<Else*>(stmt);
+		elseNode->setCondition(visit(elseNode->getCondition()));
+		foldStmt(elseNode->getifTrueStmt());
+		foldStmt(elseNode->getifFalseStmt());
+		break;
+	}
+	case NodeKind::WHILE:
+	{
+		While* whileNode = static_cast<While*>(stmt);
+		whileNode->setCondition(visit(whileNode->getCondition()));
+		foldStmt(whileNode->getStmt());
+		break;
+	}
+	case NodeKind::DO:
+	{
+		Do* doNode = static_cast<Do*>(stmt);
+		doNode->setCondition(visit(doNode->getCondition()));
+		foldStmt(doNode->getStmt());
+		break;
+	}
+	case NodeKind::PRINT:
+	{
+		Print* printNode = static_cast<Print*>(stmt);
+		printNode->setExp(visit(printNode->getExp()));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+
+// Il risultato di un'operazione sulle costanti diventa una costante; se
+// l'operazione darebbe errore si ricostruisce il nodo con gli operandi
+// ripiegati. Se nessun operando e' cambiato si riusa il nodo originale.
+Expression* ConstantFolder::visitBinOp(Arithm* arithmNode) {
+	Expression* left = visit(arithmNode->getLeftExp());
+	Expression* right = visit(arithmNode->getRightExp());
+	if (isConstant(left) && isConstant(right)) {
+		try {
+			Value v = EvaluationVisitor::arithm(arithmNode->getOp(), valueOf(left), valueOf(right));
+			++folded;
+			if (v.type == Type::INT)
+				return manager.makeIntConstant(v.value);
+			return manager.makeBoolConstant(v.value);
+		}
+		catch (EvaluationError const&) {
+		}
+	}
+	if (left == arithmNode->getLeftExp() && right == arithmNode->getRightExp())
+		return arithmNode;
+	return manager.makeBinOp(arithmNode->getOp(), left, right);
+}
+
+
+Expression* ConstantFolder::visitRel(Rel* relNode) {
+	Expression* left = visit(relNode->getLeftExp());
+	Expression* right = visit(relNode->getRightExp());
+	if (isConstant(left) && isConstant(right)) {
+		try {
+			Value v = EvaluationVisitor::rel(relNode->getOp(), valueOf(left), valueOf(right));
+			++folded;
+			return manager.makeBoolConstant(v.value);
+		}
+		catch (EvaluationError const&) {
+		}
+	}
+	if (left == relNode->getLeftExp() && right == relNode->getRightExp())
+		return relNode;
+	return manager.makeRel(left, right, relNode->getOp());
+}
+
+
+Expression* ConstantFolder::visitUnaryOp(Unary* unaryNode) {
+	Expression* exp = visit(unaryNode->getExp());
+	if (exp->getKind() == NodeKind::INT_CONSTANT) {
+		++folded;
+		return manager.makeIntConstant(EvaluationVisitor::unary(unaryNode->getOp(), valueOf(exp)).value);
+	}
+	if (exp == unaryNode->getExp())
+		return unaryNode;
+	return manager.makeUnaryOp(unaryNode->getOp(), exp);
+}
+
+
+Expression* ConstantFolder::visitNot(Not* notNode) {
+	Expression* exp = visit(notNode->getExp());
+	if (exp->getKind() == NodeKind::BOOL_CONSTANT) {
+		++folded;
+		return manager.makeBoolConstant(EvaluationVisitor::logicalNot(valueOf(exp)).value);
+	}
+	if (exp == notNode->getExp())
+		return notNode;
+	return manager.makeNot(exp);
+}
+
+
+// Con il primo operando costante And e Or non valutano il secondo (false &&
+// x e' false, true || x e' true), come in EvaluationVisitor
+Expression* ConstantFolder::visitAnd(And* andNode) {
+	Expression* left = visit(andNode->getLeftExp());
+	Expression* right = visit(andNode->getRightExp());
+	if (left->getKind() == NodeKind::BOOL_CONSTANT) {
+		bool l = valueOf(left).value != 0;
+		if (!l || right->getKind() == NodeKind::BOOL_CONSTANT) {
+			++folded;
+			return manager.makeBoolConstant(l && valueOf(right).value);
+		}
+	}
+	if (left == andNode->getLeftExp() && right == andNode->getRightExp())
+		return andNode;
+	return manager.makeAnd(left, right);
+}
+
+
+Expression* ConstantFolder::visitOr(Or* orNode) {
+	Expression* left = visit(orNode->getLeftExp());
+	Expression* right = visit(orNode->getRightExp());
+	if (left->getKind() == NodeKind::BOOL_CONSTANT) {
+		bool l = valueOf(left).value != 0;
+		if (l || right->getKind() == NodeKind::BOOL_CONSTANT) {
+			++folded;
+			return manager.makeBoolConstant(l || valueOf(right).value);
+		}
+	}
+	if (left == orNode->getLeftExp() && right == orNode->getRightExp())
+		return orNode;
+	return manager.makeOr(left, right);
+}
+
+
+Expression* ConstantFolder::visitAccess(Access* accessNode) {
+	Expression* index = visit(accessNode->getIndex());
+	if (index == accessNode->getIndex())
+		return accessNode;
+	return manager.makeAccess(accessNode->getId(), index);
+}
@@ -0,0 +1,50 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+
+#include <cstddef>
+
+#include "ExpressionManager.h"
+#include "Node.h"
+#include "Visitor.h"
+
+// Ripiegamento delle costanti: ogni espressione viene sostituita da una
+// equivalente in cui le sottoespressioni costanti sono gia' calcolate (con la
+// semantica di EvaluationVisitor). I nodi delle espressioni non vengono
+// modificati, perche' con --share possono comparire in piu' punti: quelli
+// nuovi sono creati con l'ExpressionManager e agli statement viene assegnata
+// l'espressione ripiegata. Un'operazione che darebbe errore (divisione per
+// zero, tipi sbagliati) resta com'e', cosi' che l'errore emerga durante
+// l'esecuzione.
+class ConstantFolder final : public ResultVisitor<Expression*> {
+
+public:
+	explicit ConstantFolder(ExpressionManager& em) : manager{ em } {}
+	ConstantFolder(ConstantFolder const&) = delete;
+	ConstantFolder& operator=(ConstantFolder const&) = delete;
+
+	// Ripiega le espressioni di tutti gli statement del programma (con
+	// --lazy i blocchi vengono analizzati subito)
+	void fold(Program* program);
+
+	// Numero di operazioni calcolate finora
+	std::size_t foldedCount() const { return folded; }
+
+	Expression* visitId(Id* idNode) override { return idNode; }
+	Expression* visitIntConstant(intConstant* numNode) override { return numNode; }
+	Expression* visitBoolConstant(boolConstant* boolNode) override { return boolNode; }
+	Expression* visitBinOp(Arithm* arithmNode) override;
+	Expression* visitUnaryOp(Unary* unaryNode) override;
+	Expression* visitAccess(Access* accessNode) override;
+	Expression* visitNot(Not* notNode) override;
+	Expression* visitAnd(And* andNode) override;
+	Expression* visitOr(Or* orNode) override;
+	Expression* visitRel(Rel* relNode) override;
+
+private:
+	void foldStmt(Stmt* stmt);
+
+	ExpressionManager& manager;
+	std::size_t folded = 0;
+};
+
+#endif
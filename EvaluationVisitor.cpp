@@ -0,0 +1,366 @@
+#include "EvaluationVisitor.h"
+
+#include <climits>
+#include <string>
+
+#if defined(__GNUC__)
+#define EVALUATION_COLD __attribute__((noinline, cold))
+#else
+#define EVALUATION_COLD
+#endif
+
+namespace {
+
+	std::string typeName(Value v) {
+		return Type::typeid2String[v.type];
+	}
+
+	// I messaggi di errore vengono costruiti fuori dalle funzioni chiamate a
+	// ogni valutazione, cosi' che queste restino piccole e vengano espanse
+	[[noreturn]] EVALUATION_COLD void typeError(Value v, const char* context, const char* expected) {
+		throw EvaluationError{ std::string{ "Type error: " } + context + " requires " + expected + ", found " + typeName(v) };
+	}
+
+	[[noreturn]] EVALUATION_COLD void unresolved(Id* id) {
+		throw EvaluationError{ "Name " + std::string{ id->getName() } + " not resolved" };
+	}
+
+	inline Decl* declaration(Id* id) {
+		Decl* decl = id->getDecl();
+		if (!decl)
+			unresolved(id);
+		return decl;
+	}
+
+	// celle occupate dalla variabile dichiarata da decl
+	std::size_t cellsOf(Decl* decl) {
+		Type* type = decl->getType();
+		if (type->getKind() == NodeKind::VECTOR_TYPE)
+			return static_cast<std::size_t>(static_cast<vectorType*>(type)->getSize());
+		return 1;
+	}
+
+	// aritmetica modulo 2^32, senza il comportamento indefinito dell'overflow
+	int wrap(std::uint32_t v) {
+		return static_cast<int>(v);
+	}
+
+}
+
+
+// Come ResultVisitor::visit, ma la classe e' final: le chiamate ai metodi
+// di visita sono dirette e possono essere espanse
+Value EvaluationVisitor::evaluate(Expression* exp) {
+	switch (exp->getKind()) {
+	case NodeKind::ID: return EvaluationVisitor::visitId(static_cast<Id*>(exp));
+	case NodeKind::INT_CONSTANT: return Value::ofInt(static_cast<intConstant*>(exp)->getValue());
+	case NodeKind::BOOL_CONSTANT: return Value::ofBool(static_cast<boolConstant*>(exp)->getValue());
+	case NodeKind::BIN_OP: return EvaluationVisitor::visitBinOp(static_cast<Arithm*>(exp));
+	case NodeKind::UNARY_OP: return EvaluationVisitor::visitUnaryOp(static_cast<Unary*>(exp));
+	case NodeKind::ACCESS: return EvaluationVisitor::visitAccess(static_cast<Access*>(exp));
+	case NodeKind::NOT: return EvaluationVisitor::visitNot(static_cast<Not*>(exp));
+	case NodeKind::AND: return EvaluationVisitor::visitAnd(static_cast<And*>(exp));
+	case NodeKind::OR: return EvaluationVisitor::visitOr(static_cast<Or*>(exp));
+	case NodeKind::REL: return EvaluationVisitor::visitRel(static_cast<Rel*>(exp));
+	default: return visit(exp);
+	}
+}
+
+
+void EvaluationVisitor::run(Program* program) {
+	frame.assign(program->getFrameSize(), Cell{ 0, false });
+	if (executeBlock(program->getBlock()) == Flow::BREAK)
+		throw breakOutsideLoop();
+	out.flush();
+}
+
+
+EvaluationVisitor::Flow EvaluationVisitor::execute(Stmt* stmt) {
+	switch (stmt->getKind()) {
+	case NodeKind::BLOCK:
+		return executeBlock(static_cast<Block*>(stmt));
+
+	case NodeKind::SET:
+	{
+		Set* setNode = static_cast<Set*>(stmt);
+		Id* id = setNode->getId();
+		if (declaration(id)->getType()->getKind() == NodeKind::VECTOR_TYPE)
+			throw vectorAssigned(id->getName());
+		assign(frame[setNode->getSlot()], id, evaluate(setNode->getExp()));
+		return Flow::NEXT;
+	}
+
+	case NodeKind::SET_ELEM:
+	{
+		SetElem* setElemNode = static_cast<SetElem*>(stmt);
+		Cell& cell = element(setElemNode->getId(), setElemNode->getIndex());
+		assign(cell, setElemNode->getId(), evaluate(setElemNode->getExp()));
+		return Flow::NEXT;
+	}
+
+	case NodeKind::IF:
+	{
+		If* ifNode = static_cast<If*>(stmt);
+		if (condition(ifNode->getCondition()))
+			return execute(ifNode->getStmt());
+		return Flow::NEXT;
+	}
+
+	case NodeKind::ELSE:
+	{
+		Else* elseNode = static_cast<Else*>(stmt);
+		if (condition(elseNode->getCondition()))
+			return execute(elseNode->getifTrueStmt());
+		return execute(elseNode->getifFalseStmt());
+	}
+
+	case NodeKind::WHILE:
+	{
+		While* whileNode = static_cast<While*>(stmt);
+		while (condition(whileNode->getCondition()))
+			if (execute(whileNode->getStmt()) == Flow::BREAK)
+				break;
+		return Flow::NEXT;
+	}
+
+	case NodeKind::DO:
+	{
+		Do* doNode = static_cast<Do*>(stmt);
+		do {
+			if (execute(doNode->getStmt()) == Flow::BREAK)
+				break;
+		} while (condition(doNode->getCondition()));
+		return Flow::NEXT;
+	}
+
+	case NodeKind::BREAK:
+		return Flow::BREAK;
+
+	case NodeKind::PRINT:
+	{
+		Value v = evaluate(static_cast<Print*>(stmt)->getExp());
+		if (v.type == Type::BOOL)
+			out.writeBool(v.value != 0);
+		else
+			out.writeInt(v.value);
+		return Flow::NEXT;
+	}
+
+	default:
+		throw EvaluationError{ "execution of a node that is not a statement" };
+	}
+}
+
+
+// A ogni ingresso nel blocco le sue variabili tornano non assegnate (le
+// stesse celle possono essere state usate da un blocco fratello o da
+// un'iterazione precedente)
+EvaluationVisitor::Flow EvaluationVisitor::executeBlock(Block* block) {
+	if (block->getDecls())
+		for (Decl* decl : *block->getDecls()) {
+			Cell* first = &frame[decl->getId()->getSlot()];
+			Cell* last = first + cellsOf(decl);
+			for (Cell* cell = first; cell != last; ++cell)
+				cell->defined = false;
+		}
+
+	if (block->getStmts())
+		for (Stmt* stmt : *block->getStmts())
+			if (execute(stmt) == Flow::BREAK)
+				return Flow::BREAK;
+	return Flow::NEXT;
+}
+
+
+EvaluationVisitor::Cell& EvaluationVisitor::element(Id* vector, Expression* index) {
+	Type* type = declaration(vector)->getType();
+	if (type->getKind() != NodeKind::VECTOR_TYPE)
+		throw notAVector(vector->getName());
+	const int size = static_cast<vectorType*>(type)->getSize();
+	const int i = integer(evaluate(index), "vector index");
+	if (i < 0 || i >= size)
+		throw outOfBounds(i, vector->getName(), size);
+	return frame[vector->getSlot() + i];
+}
+
+
+bool EvaluationVisitor::condition(Expression* exp) {
+	return boolean(evaluate(exp), "condition");
+}
+
+
+void EvaluationVisitor::assign(Cell& cell, Id* id, Value value) {
+	const Type::TypeCode type = declaration(id)->getType()->getType();
+	if (value.type != type)
+		throw wrongAssignment(value.type, type, id->getName());
+	cell.value = value.value;
+	cell.defined = true;
+}
+
+
+Value EvaluationVisitor::visitId(Id* idNode) {
+	Type* type = declaration(idNode)->getType();
+	if (type->getKind() == NodeKind::VECTOR_TYPE)
+		throw vectorUsedAsValue(idNode->getName());
+	const Cell& cell = frame[idNode->getSlot()];
+	if (!cell.defined)
+		throw unassigned(idNode->getName());
+	return Value{ type->getType(), cell.value };
+}
+
+
+Value EvaluationVisitor::visitAccess(Access* accessNode) {
+	const Cell& cell = element(accessNode->getId(), accessNode->getIndex());
+	if (!cell.defined)
+		throw unassignedElement(accessNode->getId()->getName());
+	return Value{ declaration(accessNode->getId())->getType()->getType(), cell.value };
+}
+
+
+Value EvaluationVisitor::visitBinOp(Arithm* arithmNode) {
+	Value left = evaluate(arithmNode->getLeftExp());
+	Value right = evaluate(arithmNode->getRightExp());
+	return arithm(arithmNode->getOp(), left, right);
+}
+
+
+Value EvaluationVisitor::visitUnaryOp(Unary* unaryNode) {
+	return unary(unaryNode->getOp(), evaluate(unaryNode->getExp()));
+}
+
+
+Value EvaluationVisitor::visitNot(Not* notNode) {
+	return logicalNot(evaluate(notNode->getExp()));
+}
+
+
+// And e Or valutano il secondo operando solo se serve
+Value EvaluationVisitor::visitAnd(And* andNode) {
+	if (!boolean(evaluate(andNode->getLeftExp()), "&&"))
+		return Value::ofBool(false);
+	return Value::ofBool(boolean(evaluate(andNode->getRightExp()), "&&"));
+}
+
+
+Value EvaluationVisitor::visitOr(Or* orNode) {
+	if (boolean(evaluate(orNode->getLeftExp()), "||"))
+		return Value::ofBool(true);
+	return Value::ofBool(boolean(evaluate(orNode->getRightExp()), "||"));
+}
+
+
+Value EvaluationVisitor::visitRel(Rel* relNode) {
+	Value left = evaluate(relNode->getLeftExp());
+	Value right = evaluate(relNode->getRightExp());
+	return rel(relNode->getOp(), left, right);
+}
+
+
+int EvaluationVisitor::integer(Value v, const char* context) {
+	if (v.type != Type::INT)
+		typeError(v, context, "int");
+	return v.value;
+}
+
+
+bool EvaluationVisitor::boolean(Value v, const char* context) {
+	if (v.type != Type::BOOL)
+		typeError(v, context, "bool");
+	return v.value != 0;
+}
+
+
+Value EvaluationVisitor::arithm(Op::BinOpCode op, Value left, Value right) {
+	if (op == Op::EQ || op == Op::NOT_EQ) {
+		if (left.type != right.type)
+			throw EvaluationError{ "Type error: comparison between " + typeName(left) + " and " + typeName(right) };
+		return Value::ofBool((left.value == right.value) == (op == Op::EQ));
+	}
+
+	const char* symbol = Op::binOp2String[op].c_str();
+	const std::uint32_t l = static_cast<std::uint32_t>(integer(left, symbol));
+	const std::uint32_t r = static_cast<std::uint32_t>(integer(right, symbol));
+	switch (op) {
+	case Op::ADD:
+		return Value::ofInt(wrap(l + r));
+	case Op::SUB:
+		return Value::ofInt(wrap(l - r));
+	case Op::MUL:
+		return Value::ofInt(wrap(l * r));
+	default:
+		if (r == 0)
+			throw EvaluationError{ "Division by zero" };
+		if (left.value == INT_MIN && right.value == -1)
+			return Value::ofInt(INT_MIN);
+		return Value::ofInt(left.value / right.value);
+	}
+}
+
+
+Value EvaluationVisitor::rel(Rel::OpCode op, Value left, Value right) {
+	const char* symbol = Rel::opCode2String[op].c_str();
+	const int l = integer(left, symbol);
+	const int r = integer(right, symbol);
+	switch (op) {
+	case Rel::MORE:
+		return Value::ofBool(l > r);
+	case Rel::MORE_EQ:
+		return Value::ofBool(l >= r);
+	case Rel::LESS:
+		return Value::ofBool(l < r);
+	default:
+		return Value::ofBool(l <= r);
+	}
+}
+
+
+Value EvaluationVisitor::unary(Op::UnaryOpCode, Value operand) {
+	return Value::ofInt(wrap(0u - static_cast<std::uint32_t>(integer(operand, "unary -"))));
+}
+
+
+Value EvaluationVisitor::logicalNot(Value operand) {
+	return Value::ofBool(!boolean(operand, "!"));
+}
+
+
+EvaluationError EvaluationVisitor::vectorUsedAsValue(std::string_view name) {
+	return EvaluationError{ "Type error: vector " + std::string{ name } + " used as a value" };
+}
+
+
+EvaluationError EvaluationVisitor::vectorAssigned(std::string_view name) {
+	return EvaluationError{ "Type error: vector " + std::string{ name } + " assigned as a whole" };
+}
+
+
+EvaluationError EvaluationVisitor::notAVector(std::string_view name) {
+	return EvaluationError{ "Type error: " + std::string{ name } + " is not a vector" };
+}
+
+
+EvaluationError EvaluationVisitor::wrongAssignment(Type::TypeCode found, Type::TypeCode variableType, std::string_view name) {
+	return EvaluationError{ "Type error: cannot assign " + Type::typeid2String[found] + " to "
+		+ Type::typeid2String[variableType] + " variable " + std::string{ name } };
+}
+
+
+EvaluationError EvaluationVisitor::unassigned(std::string_view name) {
+	return EvaluationError{ "Variable " + std::string{ name } + " used before being assigned" };
+}
+
+
+EvaluationError EvaluationVisitor::unassignedElement(std::string_view name) {
+	return EvaluationError{ "Element of vector " + std::string{ name } + " used before being assigned" };
+}
+
+
+EvaluationError EvaluationVisitor::outOfBounds(int index, std::string_view name, int size) {
+	return EvaluationError{ "Index " + std::to_string(index) + " out of bounds for vector "
+		+ std::string{ name } + "[" + std::to_string(size) + "]" };
+}
+
+
+EvaluationError EvaluationVisitor::breakOutsideLoop() {
+	return EvaluationError{ "break outside of a loop" };
+}
@@ -0,0 +1,92 @@
+#ifndef EVALUATION_VISITOR_H
+#define EVALUATION_VISITOR_H
+
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "BufferedWriter.h"
+#include "Exceptions.h"
+#include "Node.h"
+#include "Visitor.h"
+
+// Valore di un'espressione: un intero o un booleano (value vale 0 o 1)
+struct Value {
+	Type::TypeCode type;
+	int value;
+
+	static Value ofInt(int v) { return Value{ Type::INT, v }; }
+	static Value ofBool(bool b) { return Value{ Type::BOOL, b }; }
+};
+
+// Interprete ad albero. Le espressioni sono valutate con ResultVisitor<Value>
+// (il valore di ogni sottoespressione e' il risultato della sua visita), gli
+// statement sono eseguiti da execute, che restituisce se e' stato eseguito
+// un break. I nomi devono essere gia' stati risolti da Resolver: ogni
+// variabile e' una cella del frame, all'indice assegnato al suo Id. Gli
+// errori (tipi sbagliati, variabili non assegnate, indici fuori dai limiti,
+// divisione per zero) sono segnalati con EvaluationError; le stampe gia'
+// eseguite escono comunque.
+class EvaluationVisitor final : public ResultVisitor<Value> {
+
+public:
+	explicit EvaluationVisitor(std::ostream& os = std::cout) : out{ os } {}
+	EvaluationVisitor(EvaluationVisitor const&) = delete;
+	EvaluationVisitor& operator=(EvaluationVisitor const&) = delete;
+
+	// Esegue il programma dall'inizio, con tutte le variabili non assegnate
+	void run(Program* program);
+
+	Value visitId(Id* idNode) override;
+	Value visitIntConstant(intConstant* numNode) override { return Value::ofInt(numNode->getValue()); }
+	Value visitBoolConstant(boolConstant* boolNode) override { return Value::ofBool(boolNode->getValue()); }
+	Value visitBinOp(Arithm* arithmNode) override;
+	Value visitUnaryOp(Unary* unaryNode) override;
+	Value visitAccess(Access* accessNode) override;
+	Value visitNot(Not* notNode) override;
+	Value visitAnd(And* andNode) override;
+	Value visitOr(Or* orNode) override;
+	Value visitRel(Rel* relNode) override;
+
+	// Semantica degli operatori sui valori gia' calcolati, condivisa con
+	// ConstantFolder e con la VM; lanciano EvaluationError
+	static Value arithm(Op::BinOpCode op, Value left, Value right);
+	static Value rel(Rel::OpCode op, Value left, Value right);
+	static Value unary(Op::UnaryOpCode op, Value operand);
+	static Value logicalNot(Value operand);
+	// Controllo del tipo di un operando; context compare nel messaggio
+	static int integer(Value v, const char* context);
+	static bool boolean(Value v, const char* context);
+
+	// Errori di esecuzione che riguardano una variabile, condivisi con la VM
+	static EvaluationError vectorUsedAsValue(std::string_view name);
+	static EvaluationError vectorAssigned(std::string_view name);
+	static EvaluationError notAVector(std::string_view name);
+	static EvaluationError wrongAssignment(Type::TypeCode found, Type::TypeCode variableType, std::string_view name);
+	static EvaluationError unassigned(std::string_view name);
+	static EvaluationError unassignedElement(std::string_view name);
+	static EvaluationError outOfBounds(int index, std::string_view name, int size);
+	static EvaluationError breakOutsideLoop();
+
+private:
+	enum class Flow { NEXT, BREAK };
+
+	// cella del frame: una variabile o un elemento di un vettore
+	struct Cell {
+		int value;
+		bool defined;
+	};
+
+	Value evaluate(Expression* exp);
+	Flow execute(Stmt* stmt);
+	Flow executeBlock(Block* block);
+
+	Cell& element(Id* vector, Expression* index);
+	bool condition(Expression* exp);
+	void assign(Cell& cell, Id* id, Value value);
+
+	BufferedWriter out;
+	std::vector<Cell> frame;
+};
+
+#endif
@@ -1,18 +1,41 @@
 #ifndef EXPR_MANAGER_H
 #define EXPR_MANAGER_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "Arena.h"
 #include "Node.h"
 
 
 // Per risolvere il problema delle possibili "perdite di memoria"
-// creo un gestore dei nodi che provvede alla loro deallocazione
+// creo un gestore dei nodi che provvede alla loro deallocazione.
+// I nodi (e gli array a cui si riferiscono) stanno in un'Arena:
+// crearli costa un incremento di puntatore, sono disposti in memoria
+// nell'ordine del parsing e si liberano tutti insieme, senza chiamarne i
+// distruttori (nessun nodo possiede altre risorse).
+
+// Nodi condivisi dal manager (hash-consing): invece di crearne uno nuovo a
+// ogni richiesta, si restituisce il nodo gia' creato con lo stesso contenuto.
+// L'AST diventa un DAG, che non va modificato dopo la costruzione.
+// - NONE: ogni richiesta crea un nodo;
+// - LEAVES: costanti, tipi e identificatori con lo stesso valore o nome;
+// - EXPRESSIONS: anche le espressioni (senza effetti collaterali) con lo
+//   stesso operatore e gli stessi operandi, che a loro volta sono condivisi.
+enum class NodeSharing { NONE, LEAVES, EXPRESSIONS };
+
 class ExpressionManager {
 public:
     // Il costruttore di default va bene perch� invoca il costruttore
     // di default del vector che costruisce un vector vuoto
     ExpressionManager() = default;
+    explicit ExpressionManager(NodeSharing mode) : sharing{ mode } {}
     ~ExpressionManager() {
         clearMemory();
     }
@@ -25,179 +48,283 @@ public:
 
     Program* makeProgram(Block* block)
     {
-        Program* o = new Program(block);
-        allocated.push_back(o);
-        return o;
+        return create<Program>(block);
     }
     Block* makeBlock(Decls* decls, Stmts* stmts){
-        Block* o = new Block(decls, stmts);
-        allocated.push_back(o);
-        return o;
+        return create<Block>(decls, stmts);
+    }
+
+    Block* makeLazyBlock(BlockLoader* loader, std::uint32_t firstToken, std::uint32_t lastToken){
+        return create<Block>(loader, firstToken, lastToken);
+    }
+
+    // Il manager possiede anche i loader dei blocchi pigri, che devono
+    // vivere quanto i nodi che li riferiscono
+    BlockLoader* addLoader(std::unique_ptr<BlockLoader> loader){
+        loaders.push_back(std::move(loader));
+        return loaders.back().get();
+    }
+
+    // Acquisisce i nodi, gli array e i loader di other, che resta vuoto:
+    // usato per riunire i nodi creati da piu' thread, ciascuno con il
+    // proprio manager
+    void splice(ExpressionManager& other){
+        arena.splice(other.arena);
+        nodes += other.nodes;
+        other.nodes = 0;
+        // i nodi condivisi di other lo diventano anche qui, se non ce n'e'
+        // gia' uno equivalente
+        for(auto& entry : other.ints)
+            ints.insert(entry);
+        for(auto& entry : other.vectorTypes)
+            vectorTypes.insert(entry);
+        if(ids.size() < other.ids.size())
+            ids.resize(other.ids.size(), nullptr);
+        for(std::size_t i = 0; i < other.ids.size(); i++)
+            if(!ids[i])
+                ids[i] = other.ids[i];
+        for(auto& entry : other.expressions)
+            expressions.insert(entry);
+        for(int i = 0; i < 2; i++)
+            if(!bools[i])
+                bools[i] = other.bools[i];
+        for(int i = 0; i < Type::numOfTypes; i++)
+            if(!types[i])
+                types[i] = other.types[i];
+        other.forgetShared();
+        std::move(other.loaders.begin(), other.loaders.end(), std::back_inserter(loaders));
+        other.loaders.clear();
+    }
+
+    NodeSharing getSharing() const {
+        return sharing;
+    }
+
+    // Numero di nodi allocati
+    std::size_t nodeCount() const {
+        return nodes;
+    }
+
+    // Memoria occupata dai nodi
+    std::size_t bytesUsed() const {
+        return arena.bytesUsed();
+    }
+
+    // Memoria chiesta al sistema per i nodi (blocchi dell'arena)
+    std::size_t bytesReserved() const {
+        return arena.bytesReserved();
     }
 
-    Decls* makeDecls(Decl* decl, Decls* decls){
-        Decls* o = new Decls(decl, decls);
-        allocated.push_back(o);
-        return o;
+    // Le liste di dichiarazioni e di statement vengono copiate in un array
+    // contiguo posseduto dal manager
+    Decls* makeDecls(Decl* const* decls, std::size_t count){
+        Decl** items = arena.allocateArray<Decl*>(count);
+        std::copy(decls, decls + count, items);
+        return create<Decls>(items, count);
     }
 
     Decl* makeDecl(Type* type, Id* idName){
-        Decl* o = new Decl(type, idName);
-        allocated.push_back(o);
-        return o;
+        return create<Decl>(type, idName);
     }
 
     Type* makeType(Type::TypeCode type){
-        Type* o = new Type(type);
-        allocated.push_back(o);
-        return o;
+        if(sharing == NodeSharing::NONE)
+            return create<Type>(type);
+        if(!types[type])
+            types[type] = create<Type>(type);
+        return types[type];
     }
 
     vectorType* makeVectorType(Type::TypeCode type, int index){
-        vectorType* o = new vectorType(type, index);
-        allocated.push_back(o);
-        return o;
+        if(sharing == NodeSharing::NONE)
+            return create<vectorType>(type, index);
+        vectorType*& shared = vectorTypes[(static_cast<std::int64_t>(index) << 1) | type];
+        if(!shared)
+            shared = create<vectorType>(type, index);
+        return shared;
     }
 
     intConstant* makeIntConstant(int value) {
-        intConstant* o = new intConstant(value);
-        // Il metodo push_back aggiunge un elemento al vector allocated
-        allocated.push_back(o);
-        return o;
+        if(sharing == NodeSharing::NONE)
+            return create<intConstant>(value);
+        intConstant*& shared = ints[value];
+        if(!shared)
+            shared = create<intConstant>(value);
+        return shared;
     }
 
     boolConstant* makeBoolConstant(int value) {
-        boolConstant* o = new boolConstant(value);
-        // Il metodo push_back aggiunge un elemento al vector allocated
-        allocated.push_back(o);
-        return o;
+        if(sharing == NodeSharing::NONE)
+            return create<boolConstant>(value);
+        boolConstant*& shared = bools[value != 0];
+        if(!shared)
+            shared = create<boolConstant>(value);
+        return shared;
     }
 
     Arithm* makeBinOp(Op::BinOpCode op, Expression* l, Expression* r) {
-        Arithm* o = new Arithm(l, r, op);
-        allocated.push_back(o);
-        return o;
+        return share<Arithm>(ARITHM, op, l, r, l, r, op);
     }
 
     Access* makeAccess(Id* idName, Expression* index)
     {
-        Access* o = new Access(idName, index);
-        allocated.push_back(o);
-        return o;
+        return share<Access>(ACCESS, 0, idName, index, idName, index);
     }
 
     Unary* makeUnaryOp(Op::UnaryOpCode op, Expression* exp) {
-        Unary* o = new Unary(exp, op);
-        allocated.push_back(o);
-        return o;
+        return share<Unary>(UNARY, op, exp, nullptr, exp, op);
+    }
+
+    Id* makeId(Atom idName) {
+        if(sharing == NodeSharing::NONE)
+            return create<Id>(idName);
+        if(idName >= ids.size())
+            ids.resize(idName + 1, nullptr);
+        if(!ids[idName])
+            ids[idName] = create<Id>(idName);
+        return ids[idName];
     }
 
-    Id* makeId(std::string idName) {
-        Id* o = new Id(idName);
-        allocated.push_back(o);
-        return o;
+    //identificatore mai condiviso, anche con la condivisione attiva: serve
+    //a Resolver quando lo stesso nome indica variabili diverse
+    Id* makeUniqueId(Atom idName) {
+        return create<Id>(idName);
     }
     Not* makeNot(Expression* boolExpr) {
-        Not* o = new Not(boolExpr);
-        allocated.push_back(o);
-        return o;
+        return share<Not>(NOT, 0, boolExpr, nullptr, boolExpr);
     }
     And* makeAnd(Expression* boolExpr1, Expression* boolExpr2 ) {
-        And* o = new And(boolExpr1,boolExpr2);
-        allocated.push_back(o);
-        return o;
+        return share<And>(AND, 0, boolExpr1, boolExpr2, boolExpr1, boolExpr2);
     }
 
     Or* makeOr(Expression* boolExpr1, Expression* boolExpr2 ) {
-        Or* o = new Or(boolExpr1,boolExpr2);
-        allocated.push_back(o);
-        return o;
+        return share<Or>(OR, 0, boolExpr1, boolExpr2, boolExpr1, boolExpr2);
     }
 
     Rel* makeRel(Expression* boolExpr1, Expression* boolExpr2, Rel::OpCode relCode ) {
         
-        Rel* o = new Rel(boolExpr1,boolExpr2, relCode);
-        allocated.push_back(o);
-        return o;
+        return share<Rel>(REL, relCode, boolExpr1, boolExpr2, boolExpr1, boolExpr2, relCode);
     }
     
-    Stmts* makeStmts(Stmts* stmts, Stmt* stmt)
+    Stmts* makeStmts(Stmt* const* stmts, std::size_t count)
     {
-        Stmts* o = new Stmts(stmts,stmt);
-        allocated.push_back(o);
-        return o;        
+        Stmt** items = arena.allocateArray<Stmt*>(count);
+        std::copy(stmts, stmts + count, items);
+        return create<Stmts>(items, count);        
     }
 
     If* makeIf(Stmt* stmt, Expression* exp)
     {
-        If* o = new If(stmt,exp);
-        allocated.push_back(o);
-        return o;        
+        return create<If>(stmt,exp);        
     }
 
     Else* makeElse(Stmt* stmtIfTrue, Stmt* stmtIfFalse, Expression* condition)
     {
-        Else* o = new Else(stmtIfTrue, stmtIfFalse, condition);
-        allocated.push_back(o);
-        return o;        
+        return create<Else>(stmtIfTrue, stmtIfFalse, condition);        
     }
 
     While* makeWhile(Stmt* stmt, Expression* condition)
     {
-        While* o = new While(stmt, condition);
-        allocated.push_back(o);
-        return o;        
+        return create<While>(stmt, condition);        
     }
 
     Do* makeDo(Stmt* stmt, Expression* condition)
     {
-        Do* o = new Do(stmt, condition);
-        allocated.push_back(o);
-        return o;        
+        return create<Do>(stmt, condition);        
     }
 
     Set* makeSet(Id* idName, Expression* value)
     {
-        Set* o = new Set(idName, value);
-        allocated.push_back(o);
-        return o;        
+        return create<Set>(idName, value);        
     }
     
     SetElem* makeSetElem(Id* vectorName, Expression* index, Expression* value)
     {
-        SetElem* o = new SetElem(vectorName, value, index);
-        allocated.push_back(o);
-        return o;        
+        return create<SetElem>(vectorName, value, index);        
     }
 
     Break* makeBreak()
     {
-        Break* o = new Break();
-        allocated.push_back(o);
-        return o;        
+        return create<Break>();        
     }
     
     Print* makePrint(Expression* expToPrint)
     {
-        Print* o = new Print(expToPrint);
-        allocated.push_back(o);
-        return o;
+        return create<Print>(expToPrint);
     }
 
 
+    // Libera tutti i nodi: la memoria resta all'arena e viene riusata
+    // dai nodi creati in seguito
     void clearMemory() {
-        auto i = allocated.begin();
-        // allocated.end() "marca" la fine del vettore
-        // ++i sposta di un elemento la posizione "puntata" dall'iteratore
-        for (; i != allocated.end(); ++i) {
-            // *i restituisce l'elemento "puntato" dall'iteratore
-            delete(*i);
-        }
-        allocated.resize(0);
+        arena.reset();
+        nodes = 0;
+        loaders.clear();
+        forgetShared();
     }
 
 private:
-    std::vector<Node*> allocated;
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        ++nodes;
+        return arena.create<T>(std::forward<Args>(args)...);
+    }
+
+    // Espressioni condivise nel modo EXPRESSIONS: la chiave e' il tipo di
+    // nodo, l'operatore e gli operandi (gia' condivisi, quindi basta
+    // confrontarne gli indirizzi)
+    enum SharedKind { ARITHM, REL, AND, OR, NOT, UNARY, ACCESS };
+    struct ExpressionKey {
+        int kind;
+        int op;
+        const Node* left;
+        const Node* right;
+        bool operator==(const ExpressionKey& other) const {
+            return kind == other.kind && op == other.op && left == other.left && right == other.right;
+        }
+    };
+    struct ExpressionKeyHash {
+        std::size_t operator()(const ExpressionKey& key) const {
+            std::uint64_t h = (static_cast<std::uint64_t>(key.kind) << 8) | static_cast<std::uint8_t>(key.op);
+            h = (h ^ reinterpret_cast<std::uintptr_t>(key.left)) * 0x9E3779B97F4A7C15ull;
+            h = (h ^ reinterpret_cast<std::uintptr_t>(key.right)) * 0x9E3779B97F4A7C15ull;
+            return static_cast<std::size_t>(h ^ (h >> 32));
+        }
+    };
+
+    template <typename T, typename... Args>
+    T* share(SharedKind kind, int op, const Node* left, const Node* right, Args&&... args) {
+        if(sharing != NodeSharing::EXPRESSIONS)
+            return create<T>(std::forward<Args>(args)...);
+        Expression*& shared = expressions[ExpressionKey{ kind, op, left, right }];
+        if(!shared)
+            shared = create<T>(std::forward<Args>(args)...);
+        return static_cast<T*>(shared);
+    }
+
+    void forgetShared() {
+        ints.clear();
+        vectorTypes.clear();
+        ids.clear();
+        expressions.clear();
+        bools[0] = bools[1] = nullptr;
+        std::fill(std::begin(types), std::end(types), nullptr);
+    }
+
+    Arena arena;
+    std::size_t nodes = 0;
+
+    NodeSharing sharing = NodeSharing::NONE;
+    std::unordered_map<int, intConstant*> ints;
+    boolConstant* bools[2] = { nullptr, nullptr };
+    Type* types[Type::numOfTypes] = {};
+    // chiave: dimensione e tipo degli elementi
+    std::unordered_map<std::int64_t, vectorType*> vectorTypes;
+    // indicizzati per atomo
+    std::vector<Id*> ids;
+    std::unordered_map<ExpressionKey, Expression*, ExpressionKeyHash> expressions;
+
+    std::vector<std::unique_ptr<BlockLoader>> loaders;
 };
 
 
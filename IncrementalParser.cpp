@@ -0,0 +1,376 @@
+#include "IncrementalParser.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Atoms.h"
+#include "Exceptions.h"
+#include "StructureIndex.h"
+#include "Tokenizer.h"
+
+namespace {
+
+	// Lunghezza del prefisso comune di a e b (di lunghezza almeno n),
+	// confrontando a blocchi con memcmp
+	std::size_t commonPrefix(const char* a, const char* b, std::size_t n) {
+		constexpr std::size_t chunk = 4096;
+		std::size_t i = 0;
+		while (i + chunk <= n && std::memcmp(a + i, b + i, chunk) == 0)
+			i += chunk;
+		while (i < n && a[i] == b[i])
+			++i;
+		return i;
+	}
+
+	// Lunghezza del suffisso comune di [a - n, a) e [b - n, b)
+	std::size_t commonSuffix(const char* a, const char* b, std::size_t n) {
+		constexpr std::size_t chunk = 4096;
+		std::size_t i = 0;
+		while (i + chunk <= n && std::memcmp(a - i - chunk, b - i - chunk, chunk) == 0)
+			i += chunk;
+		while (i < n && a[-1 - static_cast<std::ptrdiff_t>(i)] == b[-1 - static_cast<std::ptrdiff_t>(i)])
+			++i;
+		return i;
+	}
+
+}
+
+
+Program* IncrementalParser::parse(std::string source) {
+	manager.reset();
+	program = nullptr;
+	spans.clear();
+	statementStarts.clear();
+	tokens = Tokenizer{}(SourceBuffer::fromMemory(std::move(source)));
+
+	stats = Stats{};
+	stats.tokensRelexed = tokens.size();
+	return fullParse();
+}
+
+
+// Se l'analisi fallisce la modifica viene annullata, cosi' la versione
+// successiva verra' confrontata con l'ultima analizzata con successo
+Program* IncrementalParser::update(std::string source) {
+	if (!program)
+		return parse(std::move(source));
+
+	Edit edit = relex(source);
+	const std::size_t firstChanged = edit.first;
+	const std::size_t lastChanged = edit.first + edit.removed;
+	const std::size_t newCount = edit.inserted.size();
+	stats = Stats{};
+	stats.tokensRelexed = newCount;
+	stats.tokensKept = tokens.size() - edit.removed;
+
+	SourceBuffer previous = apply(edit, SourceBuffer::fromMemory(std::move(source)));
+	try {
+		return reparse(firstChanged, lastChanged, newCount);
+	}
+	catch (...) {
+		// edit ora descrive la modifica inversa
+		apply(edit, std::move(previous));
+		throw;
+	}
+}
+
+
+Program* IncrementalParser::reparse(std::size_t firstChanged, std::size_t lastChanged,
+	std::size_t newCount) {
+
+	// sono cambiati solo spazi bianchi: sono cambiate solo le posizioni dei token
+	if (firstChanged == lastChanged && newCount == 0)
+		return program;
+
+	if (manager->nodeCount() > garbageFactor * liveNodes)
+		return fullParse();
+
+	// Blocco piu' interno che contiene i token cambiati senza che lo siano
+	// le sue graffe: gli intervalli sono annidati e ordinati per inizio,
+	// quindi e' il primo che li contiene risalendo dall'ultimo che inizia
+	// prima di firstChanged
+	auto after = std::partition_point(spans.begin(), spans.end(),
+		[&](const BlockSpan& s) { return s.first < firstChanged; });
+	auto enclosing = std::find_if(std::make_reverse_iterator(after), spans.rend(),
+		[&](const BlockSpan& s) { return s.last >= lastChanged; });
+	if (enclosing == spans.rend())
+		return fullParse();
+
+	const std::size_t b = spans.rend() - enclosing - 1;
+	const BlockSpan outer = spans[b];
+	const std::int64_t tokenDelta = static_cast<std::int64_t>(newCount)
+		- static_cast<std::int64_t>(lastChanged - firstChanged);
+	auto shift = [&](std::uint32_t& index) {
+		index = static_cast<std::uint32_t>(index + tokenDelta);
+	};
+
+	// Token da rianalizzare [regionFirst, regionEnd) nello stream
+	// precedente: tutto il blocco o solo gli statement [firstStmt, endStmt)
+	std::size_t firstStmt = 0, endStmt = 0;
+	const bool byStatement = b == 0 && statementRange(firstChanged, lastChanged, firstStmt, endStmt);
+	std::uint32_t regionFirst = outer.first;
+	std::uint32_t regionEnd = outer.last + 1;
+	if (byStatement) {
+		regionFirst = statementStarts[firstStmt];
+		regionEnd = endStmt < statementStarts.size() ? statementStarts[endStmt] : outer.last;
+	}
+
+	// Blocchi contenuti nella zona (contigui) che non contengono token
+	// cambiati, con le posizioni nel nuovo stream
+	std::size_t interiorBegin = b + 1;
+	if (byStatement)
+		interiorBegin = std::partition_point(spans.begin() + interiorBegin, spans.end(),
+			[&](const BlockSpan& s) { return s.first < regionFirst; }) - spans.begin();
+	std::size_t interiorEnd = interiorBegin;
+	while (interiorEnd < spans.size() && spans[interiorEnd].first < regionEnd)
+		++interiorEnd;
+	std::vector<BlockSpan> reusable;
+	for (std::size_t i = interiorBegin; i < interiorEnd; ++i) {
+		BlockSpan s = spans[i];
+		if (s.first >= lastChanged) {
+			shift(s.first);
+			shift(s.last);
+		}
+		else if (s.last >= firstChanged)
+			continue;
+		reusable.push_back(s);
+	}
+
+	// Il nuovo contenuto viene trasferito nell'AST solo se tutto e' andato
+	// bene: se il parsing fallisce l'AST precedente resta intatto
+	std::vector<BlockSpan> interior;
+	Parser parser(*manager, tokens, nullptr, regionFirst);
+	parser.spanSink = &interior;
+	parser.reuseItr = reusable.data();
+	parser.reuseEnd = reusable.data() + reusable.size();
+	std::uint32_t newEnd = regionEnd;
+	shift(newEnd);
+
+	// nel primo caso il primo intervallo e' quello del Block temporaneo
+	std::size_t skipped = 0;
+	if (byStatement) {
+		// dove finiva uno statement ora ne deve finire uno: quelli che
+		// seguono sono analizzati come prima
+		std::vector<Stmt*> fresh;
+		std::vector<std::uint32_t> starts;
+		while (parser.tokenIndex() < newEnd) {
+			starts.push_back(static_cast<std::uint32_t>(parser.tokenIndex()));
+			fresh.push_back(parser.parseStmt());
+		}
+		if (parser.tokenIndex() != newEnd)
+			return fullParse();
+
+		Block* block = outer.block;
+		Stmts* stmts = block->getStmts();
+		if (fresh.size() == endStmt - firstStmt) {
+			std::copy(fresh.begin(), fresh.end(), stmts->begin() + firstStmt);
+		}
+		else {
+			std::vector<Stmt*> all(stmts->begin(), stmts->begin() + firstStmt);
+			all.insert(all.end(), fresh.begin(), fresh.end());
+			all.insert(all.end(), stmts->begin() + endStmt, stmts->end());
+			block->setContents(block->getDecls(),
+				all.empty() ? Stmts::EMPTY_STMTS : manager->makeStmts(all.data(), all.size()));
+		}
+
+		for (std::size_t i = endStmt; i < statementStarts.size(); ++i)
+			shift(statementStarts[i]);
+		statementStarts.erase(statementStarts.begin() + firstStmt, statementStarts.begin() + endStmt);
+		statementStarts.insert(statementStarts.begin() + firstStmt, starts.begin(), starts.end());
+	}
+	else {
+		Block* fresh = parser.parseBlock();
+		// le graffe non corrispondono piu' come prima
+		if (parser.tokenIndex() != newEnd)
+			return fullParse();
+
+		outer.block->setContents(fresh->getDecls(), fresh->getStmts());
+		skipped = 1;
+	}
+	stats.blockTokens = newEnd - regionFirst;
+
+	// Intervalli interni: quelli trovati dal Parser con i discendenti dei
+	// blocchi riusati
+	std::vector<BlockSpan> updated;
+	for (std::size_t k = skipped; k < interior.size(); ++k) {
+		updated.push_back(interior[k]);
+		auto reused = std::lower_bound(reusable.begin(), reusable.end(), interior[k].first,
+			[](const BlockSpan& s, std::uint32_t first) { return s.first < first; });
+		if (reused == reusable.end() || reused->block != interior[k].block)
+			continue;
+		++stats.blocksReused;
+		for (++reused; reused != reusable.end() && reused->first < interior[k].last; ++reused)
+			updated.push_back(*reused);
+	}
+
+	// Quelli che contengono la zona finiscono dopo la modifica e quelli
+	// che la seguono si spostano con i loro token
+	if (tokenDelta != 0) {
+		for (std::size_t i = 0; i < interiorBegin; ++i)
+			if (spans[i].last >= lastChanged)
+				shift(spans[i].last);
+		for (std::size_t i = interiorEnd; i < spans.size(); ++i) {
+			shift(spans[i].first);
+			shift(spans[i].last);
+		}
+	}
+	auto interiorFirst = spans.begin() + interiorBegin;
+	const std::size_t replaced = interiorEnd - interiorBegin;
+	if (updated.size() >= replaced) {
+		std::copy(updated.begin(), updated.begin() + replaced, interiorFirst);
+		spans.insert(spans.begin() + interiorEnd, updated.begin() + replaced, updated.end());
+	}
+	else {
+		std::copy(updated.begin(), updated.end(), interiorFirst);
+		spans.erase(interiorFirst + updated.size(), spans.begin() + interiorEnd);
+	}
+
+	// Gli statement del blocco piu' esterno: se e' stato rianalizzato tutto
+	// si ricalcolano, altrimenti quelli che seguono la modifica si spostano
+	if (!byStatement) {
+		if (b == 0)
+			indexStatements();
+		else if (tokenDelta != 0)
+			for (std::uint32_t& start : statementStarts)
+				if (start >= lastChanged)
+					shift(start);
+	}
+	return program;
+}
+
+
+bool IncrementalParser::statementRange(std::size_t firstChanged, std::size_t lastChanged,
+	std::size_t& first, std::size_t& end) const {
+
+	// prima del primo statement ci sono le dichiarazioni
+	if (statementStarts.empty() || firstChanged <= statementStarts.front())
+		return false;
+
+	// Si parte dallo statement precedente anche se i token cambiati ne
+	// iniziano uno: per decidere dove finisce, un if ha esaminato il token
+	// che lo segue (che ora potrebbe essere un else)
+	first = std::upper_bound(statementStarts.begin(), statementStarts.end(), firstChanged)
+		- statementStarts.begin() - 1;
+	if (statementStarts[first] == firstChanged)
+		--first;
+	end = std::lower_bound(statementStarts.begin() + first, statementStarts.end(), lastChanged)
+		- statementStarts.begin();
+	return true;
+}
+
+
+void IncrementalParser::indexStatements() {
+	// StructureIndex omette il primo statement se il blocco non ha
+	// dichiarazioni (segue direttamente la '{')
+	StructureIndex index(tokens);
+	statementStarts = index.getStatementStarts();
+	Block* block = program->getBlock();
+	Stmts* stmts = block->getStmts();
+	const std::size_t count = stmts ? stmts->getSize() : 0;
+	if (block->getDecls() == Decls::EMPTY_DECLS && statementStarts.size() + 1 == count)
+		statementStarts.insert(statementStarts.begin(), 1);
+	// le posizioni sono esatte per i programmi corretti: altrimenti si
+	// rianalizza sempre tutto il blocco
+	if (statementStarts.size() != count)
+		statementStarts.clear();
+}
+
+
+Program* IncrementalParser::fullParse() {
+	auto newManager = std::make_unique<ExpressionManager>();
+	std::vector<BlockSpan> newSpans;
+	Parser parser(*newManager, tokens, ParseMode::STRICT);
+	parser.spanSink = &newSpans;
+	Program* newProgram = parser();
+
+	manager = std::move(newManager);
+	program = newProgram;
+	spans = std::move(newSpans);
+	indexStatements();
+	liveNodes = manager->nodeCount();
+	stats.fullParse = true;
+	stats.blockTokens = tokens.size();
+	return program;
+}
+
+
+// Il lexer non ha stato fra un token e l'altro: se nella parte finale
+// comune ai due sorgenti un nuovo token inizia dove (a meno dello
+// spostamento) iniziava un vecchio token, da li' in poi i token coincidono.
+IncrementalParser::Edit IncrementalParser::relex(const std::string& source) const {
+	const SourceBuffer& old = tokens.getSource();
+	const std::vector<Token>& oldTokens = tokens.getTokens();
+	const std::size_t oldCount = tokens.size();
+	Tokenizer::checkSourceSize(source.size());
+
+	std::size_t common = std::min(old.size(), source.size());
+	std::size_t prefix = commonPrefix(old.data(), source.data(), common);
+	std::size_t suffix = commonSuffix(old.end(), source.data() + source.size(), common - prefix);
+
+	Edit edit;
+	edit.delta = static_cast<std::int64_t>(source.size()) - static_cast<std::int64_t>(old.size());
+
+	// Restano i token che finiscono prima del prefisso comune, con un
+	// carattere di margine: per riconoscere un operatore il lexer puo'
+	// aver esaminato il carattere che segue il token
+	auto kept = std::partition_point(oldTokens.begin(), oldTokens.begin() + oldCount,
+		[&](const Token& t) { return t.offset + t.length + 1 < prefix; });
+	edit.first = kept - oldTokens.begin();
+
+	const char* base = source.data();
+	const char* end = base + source.size();
+	const char* p = base;
+	if (edit.first > 0)
+		p += oldTokens[edit.first - 1].offset + oldTokens[edit.first - 1].length;
+	const std::size_t suffixStart = source.size() - suffix;
+
+	std::size_t resync = oldCount;
+	for (;;) {
+		p = Tokenizer::skipWhitespace(p, end);
+		if (p == end)
+			break;
+		std::size_t pos = p - base;
+		if (pos >= suffixStart) {
+			std::uint32_t oldPos = static_cast<std::uint32_t>(pos - edit.delta);
+			auto same = std::lower_bound(kept, oldTokens.begin() + oldCount, oldPos,
+				[](const Token& t, std::uint32_t offset) { return t.offset < offset; });
+			if (same != oldTokens.begin() + oldCount && same->offset == oldPos) {
+				resync = same - oldTokens.begin();
+				break;
+			}
+		}
+		Token token{ Token::END_OF_INPUT, 0, 0 };
+		p = Tokenizer::scanToken(p, end, base, token);
+		edit.inserted.push_back(token);
+	}
+	AtomTable::global().internIds(edit.inserted.data(), edit.inserted.data() + edit.inserted.size(), base);
+	edit.removed = resync - edit.first;
+	return edit;
+}
+
+
+SourceBuffer IncrementalParser::apply(Edit& edit, SourceBuffer source) {
+	std::vector<Token>& all = tokens.getTokens();
+	auto first = all.begin() + edit.first;
+	auto tail = first + edit.removed;
+
+	// i token che seguono (compreso END_OF_INPUT) si spostano nel sorgente
+	if (edit.delta != 0)
+		for (auto t = tail; t != all.end(); ++t)
+			t->offset = static_cast<std::uint32_t>(t->offset + edit.delta);
+
+	std::vector<Token> removed(first, tail);
+	if (edit.inserted.size() >= edit.removed) {
+		std::copy(edit.inserted.begin(), edit.inserted.begin() + edit.removed, first);
+		all.insert(tail, edit.inserted.begin() + edit.removed, edit.inserted.end());
+	}
+	else {
+		std::copy(edit.inserted.begin(), edit.inserted.end(), first);
+		all.erase(first + edit.inserted.size(), tail);
+	}
+
+	edit.removed = edit.inserted.size();
+	edit.inserted = std::move(removed);
+	edit.delta = -edit.delta;
+	return tokens.exchangeSource(std::move(source));
+}
@@ -0,0 +1,111 @@
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ExpressionManager.h"
+#include "Node.h"
+#include "Parser.h"
+#include "TokenStream.h"
+
+// Analisi incrementale di versioni successive dello stesso sorgente (usata
+// dalla modalita' --watch). Per ogni nuova versione:
+// - si confronta il testo con quello precedente e si rilessa solo la zona
+//   modificata, finche' i token non tornano a coincidere con i precedenti;
+//   lo stream viene modificato sul posto (i token seguenti vengono solo
+//   spostati, se cambia la lunghezza del sorgente);
+// - si rianalizza solo il blocco piu' interno che contiene tutti i token
+//   cambiati, le cui parentesi graffe non sono cambiate: il nodo Block resta
+//   lo stesso e ne viene sostituito il contenuto;
+// - se quel blocco e' il piu' esterno e la modifica non tocca le sue
+//   dichiarazioni, si rianalizzano solo gli statement che contengono i
+//   token cambiati, sostituendoli nel suo array Stmts;
+// - i blocchi annidati i cui token non sono cambiati vengono riusati cosi'
+//   come sono, senza rianalizzarli.
+// Se non esiste un blocco adatto si rianalizza tutto, con un nuovo
+// ExpressionManager. In caso di errore (LexicalError o ParseError) resta
+// valida la versione precedente, rispetto a cui si confrontera' la successiva.
+class IncrementalParser {
+
+public:
+	IncrementalParser() = default;
+	IncrementalParser(IncrementalParser const&) = delete;
+	IncrementalParser& operator=(IncrementalParser const&) = delete;
+
+	// Cosa e' stato fatto nell'ultimo aggiornamento
+	struct Stats {
+		bool fullParse = false;			// tutto il sorgente e' stato rianalizzato
+		std::size_t tokensRelexed = 0;	// token prodotti dal lexer
+		std::size_t tokensKept = 0;		// token presi dalla versione precedente
+		std::size_t blockTokens = 0;	// token del blocco o degli statement rianalizzati
+		std::size_t blocksReused = 0;	// blocchi annidati riusati
+	};
+
+	// Analizza source da zero
+	Program* parse(std::string source);
+
+	// Aggiorna l'AST per una nuova versione del sorgente
+	Program* update(std::string source);
+
+	Program* getProgram() const { return program; }
+	const TokenStream& getTokens() const { return tokens; }
+	const Stats& lastStats() const { return stats; }
+
+private:
+	// Differenza fra due versioni dello stream di token
+	struct Edit {
+		std::size_t first = 0;			// primo token sostituito
+		std::size_t removed = 0;		// token sostituiti
+		std::vector<Token> inserted;	// token che li sostituiscono
+		std::int64_t delta = 0;			// variazione della lunghezza del sorgente
+	};
+
+	// Rilessa la zona di source diversa dal sorgente corrente
+	Edit relex(const std::string& source) const;
+
+	// Applica edit allo stream, che prende source come sorgente, e
+	// restituisce il sorgente precedente e (in edit) i token rimossi:
+	// applicando il risultato si annulla la modifica
+	SourceBuffer apply(Edit& edit, SourceBuffer source);
+
+	// Rianalizza il blocco che contiene i token [firstChanged, lastChanged)
+	// dello stream precedente, sostituiti da newCount token (o tutto)
+	Program* reparse(std::size_t firstChanged, std::size_t lastChanged, std::size_t newCount);
+
+	// Rianalizza tutto lo stream con un nuovo manager
+	Program* fullParse();
+
+	// Statement [first, end) del blocco piu' esterno che contengono i token
+	// [firstChanged, lastChanged); false se la modifica puo' riguardare
+	// anche le dichiarazioni
+	bool statementRange(std::size_t firstChanged, std::size_t lastChanged,
+		std::size_t& first, std::size_t& end) const;
+
+	// Ricostruisce statementStarts con StructureIndex
+	void indexStatements();
+
+	TokenStream tokens;
+	std::unique_ptr<ExpressionManager> manager;
+	Program* program = nullptr;
+
+	// Intervalli di tutti i blocchi dell'AST, in ordine di posizione
+	std::vector<BlockSpan> spans;
+
+	// Posizione del primo token di ogni statement del blocco piu' esterno
+	// (vuoto se non e' nota)
+	std::vector<std::uint32_t> statementStarts;
+
+	// Nodi vivi dopo l'ultima analisi completa: i contenuti sostituiti dei
+	// blocchi restano nel manager, che viene rinnovato quando i nodi
+	// superano garbageFactor volte questo numero
+	std::size_t liveNodes = 0;
+	static constexpr std::size_t garbageFactor = 2;
+
+	Stats stats;
+};
+
+#endif
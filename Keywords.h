@@ -0,0 +1,96 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#include "Token.h"
+
+// Riconoscimento delle keyword con una funzione hash perfetta generata a
+// tempo di compilazione a partire da Token::keywordsId / Token::id2word.
+// L'hash dipende solo da lunghezza, primo e ultimo carattere della parola:
+// ad ogni slot della tabella corrisponde al piu' una keyword, quindi per
+// classificare un identificatore basta un accesso alla tabella e un confronto.
+namespace Keywords {
+
+	// numero di slot della tabella (potenza di 2)
+	constexpr std::size_t tableSize = 32;
+
+	constexpr std::size_t length(const char* word) {
+		std::size_t n = 0;
+		while (word[n] != '\0')
+			++n;
+		return n;
+	}
+
+	constexpr std::size_t hash(unsigned multiplier, unsigned char first,
+		unsigned char last, std::size_t len) {
+		return (first * multiplier + last + len) & (tableSize - 1);
+	}
+
+	struct Table {
+		// moltiplicatore per cui l'hash e' privo di collisioni
+		unsigned multiplier = 0;
+		// token keyword associato ad ogni slot, -1 se lo slot e' vuoto
+		std::array<int, tableSize> slots{};
+		// lunghezza della keyword di ogni slot
+		std::array<std::size_t, tableSize> lengths{};
+		std::size_t minLength = 0;
+		std::size_t maxLength = 0;
+	};
+
+	// Cerca il primo moltiplicatore che distribuisce tutte le keyword
+	// in slot distinti
+	constexpr Table build() {
+		for (unsigned multiplier = 1; multiplier < 4096; ++multiplier) {
+			Table table{};
+			table.multiplier = multiplier;
+			table.minLength = ~std::size_t{ 0 };
+			for (std::size_t i = 0; i < tableSize; ++i)
+				table.slots[i] = -1;
+
+			bool collision = false;
+			for (int i = 0; i < Token::keywordsIdSize && !collision; ++i) {
+				int id = Token::keywordsId[i];
+				const char* word = Token::id2word[id];
+				std::size_t len = length(word);
+				std::size_t slot = hash(multiplier, word[0], word[len - 1], len);
+				if (table.slots[slot] != -1)
+					collision = true;
+				table.slots[slot] = id;
+				table.lengths[slot] = len;
+				if (len < table.minLength) table.minLength = len;
+				if (len > table.maxLength) table.maxLength = len;
+			}
+			if (!collision)
+				return table;
+		}
+		return Table{};
+	}
+
+	constexpr Table table = build();
+
+	static_assert(table.multiplier != 0,
+		"nessuna funzione hash perfetta per le keyword: aumentare tableSize");
+
+	// Restituisce l'id del token keyword corrispondente a word, -1 se word
+	// non e' una keyword
+	inline int lookup(std::string_view word) {
+		std::size_t len = word.size();
+		if (len < table.minLength || len > table.maxLength)
+			return -1;
+		std::size_t slot = hash(table.multiplier,
+			static_cast<unsigned char>(word[0]),
+			static_cast<unsigned char>(word[len - 1]), len);
+		int id = table.slots[slot];
+		if (id < 0 || table.lengths[slot] != len
+			|| std::memcmp(Token::id2word[id], word.data(), len) != 0)
+			return -1;
+		return id;
+	}
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef LEXER_TABLES_H
+#define LEXER_TABLES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Token.h"
+
+// Tabelle del lexer generate a tempo di compilazione dalle parole dei simboli
+// terminali fissi (Token::id2word[FIRST_SYMBOL..LAST_SYMBOL]):
+// - charClass: classe di ogni byte, per scegliere con un solo accesso il ramo
+//   del lexer (spazio, lettera, cifra, inizio di operatore, altro);
+// - l'automa degli operatori: uno stato per ogni prefisso delle parole dei
+//   simboli, con transizioni su un alfabeto compresso ai soli caratteri che
+//   vi compaiono e, per ogni stato, il token riconosciuto (se esiste).
+// Aggiungere un operatore in Token.h rigenera automaticamente le tabelle.
+namespace LexerTables {
+
+	enum CharClass : std::uint8_t { OTHER, SPACE, ALPHA, DIGIT, SYMBOL };
+
+	// nessuna transizione / nessun token accettato
+	constexpr std::uint8_t NONE = 0xFF;
+
+	// dimensioni massime dell'automa (verificate con static_assert)
+	constexpr std::size_t maxStates = 64;
+	constexpr std::size_t maxColumns = 32;
+
+	struct Tables {
+		std::array<CharClass, 256> charClass{};
+
+		// colonna dell'automa per ogni byte (NONE se non compare nei simboli)
+		std::array<std::uint8_t, 256> column{};
+		std::size_t columns = 0;
+
+		// transizioni[stato][colonna] -> stato (NONE se assente)
+		std::array<std::array<std::uint8_t, maxColumns>, maxStates> next{};
+		// token accettato in ogni stato (NONE se lo stato non e' finale)
+		std::array<std::uint8_t, maxStates> accept{};
+		// true se dallo stato esce almeno una transizione
+		std::array<bool, maxStates> extends{};
+		std::size_t states = 0;
+
+		bool overflow = false;
+	};
+
+	constexpr Tables build() {
+		Tables t{};
+
+		for (int c = 0; c < 256; ++c) {
+			t.column[c] = NONE;
+			if (c == ' ' || (c >= '\t' && c <= '\r'))
+				t.charClass[c] = SPACE;
+			else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+				t.charClass[c] = ALPHA;
+			else if (c >= '0' && c <= '9')
+				t.charClass[c] = DIGIT;
+			else
+				t.charClass[c] = OTHER;
+		}
+
+		for (auto& row : t.next)
+			for (auto& cell : row)
+				cell = NONE;
+		for (auto& a : t.accept)
+			a = NONE;
+		t.states = 1;	// stato iniziale: prefisso vuoto
+
+		for (int tag = Token::FIRST_SYMBOL; tag <= Token::LAST_SYMBOL; ++tag) {
+			const char* word = Token::id2word[tag];
+			std::size_t state = 0;
+			for (std::size_t i = 0; word[i] != '\0'; ++i) {
+				unsigned char c = static_cast<unsigned char>(word[i]);
+				if (i == 0)
+					t.charClass[c] = SYMBOL;
+				if (t.column[c] == NONE) {
+					if (t.columns == maxColumns) {
+						t.overflow = true;
+						return t;
+					}
+					t.column[c] = static_cast<std::uint8_t>(t.columns++);
+				}
+				t.extends[state] = true;
+				std::uint8_t& target = t.next[state][t.column[c]];
+				if (target == NONE) {
+					if (t.states == maxStates) {
+						t.overflow = true;
+						return t;
+					}
+					target = static_cast<std::uint8_t>(t.states++);
+				}
+				state = target;
+			}
+			t.accept[state] = static_cast<std::uint8_t>(tag);
+		}
+		return t;
+	}
+
+	constexpr Tables tables = build();
+
+	static_assert(!tables.overflow, "automa degli operatori troppo grande: aumentare maxStates/maxColumns");
+	static_assert(Token::LAST_SYMBOL < NONE, "i tag dei simboli devono stare in un byte");
+
+	inline CharClass classOf(char c) {
+		return tables.charClass[static_cast<unsigned char>(c)];
+	}
+
+	// Stato raggiunto da state leggendo c (NONE se non c'e' transizione)
+	inline std::uint8_t step(std::uint8_t state, char c) {
+		std::uint8_t col = tables.column[static_cast<unsigned char>(c)];
+		return col == NONE ? NONE : tables.next[state][col];
+	}
+
+}
+
+#endif
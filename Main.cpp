@@ -1,65 +1,347 @@
 #include <iostream>
 #include <string>
+#include <cstring>
 #include <stdlib.h>
 #include <fstream>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <filesystem>
 
 #include "Exceptions.h"
 #include "Token.h"
 #include "Tokenizer.h"
+#include "StreamLexer.h"
 #include "ExpressionManager.h"
 #include "Parser.h"
+#include "IncrementalParser.h"
+#include "SourceBuffer.h"
+#include "CompileCache.h"
+#include "ProgramImage.h"
+#include "CompactAst.h"
+#include "CompactParser.h"
 #include "Visitor.h"
+#include "EvaluationVisitor.h"
+#include "ConstantFolder.h"
+#include "AstStats.h"
+#include "Resolver.h"
+#include "BytecodeCompiler.h"
+#include "VirtualMachine.h"
+#include "Benchmark.h"
+
+
+// Modalita' --watch: il file viene riletto a ogni modifica e l'AST viene
+// aggiornato in modo incrementale. Per ogni versione si stampa quanto e'
+// stato rilessato e rianalizzato e in quanto tempo; si termina con Ctrl-C.
+static int watch(const std::string& fileName) {
+    IncrementalParser session;
+    std::filesystem::file_time_type lastWrite{};
+    std::uintmax_t lastSize = 0;
+    bool first = true;
+
+    for (;;) {
+        std::error_code ec;
+        auto writeTime = std::filesystem::last_write_time(fileName, ec);
+        std::uintmax_t size = ec ? 0 : std::filesystem::file_size(fileName, ec);
+        if (ec && first) {
+            std::cerr << "Cannot read from " << fileName << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (!ec && (first || writeTime != lastWrite || size != lastSize)) {
+            first = false;
+            lastWrite = writeTime;
+            lastSize = size;
+            try {
+                SourceBuffer buffer{ fileName };
+                std::string source(buffer.data(), buffer.size());
+
+                auto start = std::chrono::steady_clock::now();
+                session.update(std::move(source));
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+                const IncrementalParser::Stats& stats = session.lastStats();
+                std::cout << fileName << ": " << elapsed.count() << " ms, "
+                          << stats.tokensRelexed << " token rilessati su " << session.getTokens().size() << ", ";
+                if (stats.fullParse)
+                    std::cout << "analisi completa" << std::endl;
+                else
+                    std::cout << "blocco di " << stats.blockTokens << " token rianalizzato ("
+                              << stats.blocksReused << " blocchi riusati)" << std::endl;
+            }
+            catch (LexicalError const& le) {
+                std::cerr << "Lexical error" << std::endl;
+                std::cerr << le.what() << std::endl;
+            }
+            catch (ParseError const& pe) {
+                std::cerr << "Parse error" << std::endl;
+                std::cerr << pe.what() << std::endl;
+            }
+            catch (std::exception const& exc) {
+                std::cerr << "Cannot read from " << fileName << std::endl;
+                std::cerr << exc.what() << std::endl;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
 
 
 int main(int argc, char* argv[]) {
 
     // Command line parsing
-    if (argc < 2) {
-        std::cerr << "File not found!" << std::endl;
-        std::cerr << "Usage: " << argv[0] << " <file_name>" << std::endl;
-        return EXIT_FAILURE;
+    std::string fileName;
+    bool benchLex = false;
+    bool benchKeywords = false;
+    bool benchScan = false;
+    bool benchParallelLex = false;
+    bool benchParse = false;
+    bool benchParallelParse = false;
+    bool benchIncremental = false;
+    bool watchMode = false;
+    bool benchCache = false;
+    bool benchCompact = false;
+    bool benchVisit = false;
+    bool benchEval = false;
+    bool foldConstants = false;
+    bool evaluate = false;
+    bool useVm = false;
+    bool astStats = false;
+    bool astStatsJson = false;
+    bool compactMode = false;
+    NodeSharing sharing = NodeSharing::NONE;
+    std::string cacheDir;
+    unsigned lexThreads = 1;
+    unsigned parseThreads = 1;
+    bool streamMode = false;
+    bool lazyParse = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench-lex")
+            benchLex = true;
+        else if (arg == "--bench-keywords")
+            benchKeywords = true;
+        else if (arg == "--bench-scan")
+            benchScan = true;
+        else if (arg == "--bench-parallel-lex")
+            benchParallelLex = true;
+        else if (arg == "--bench-parse")
+            benchParse = true;
+        else if (arg == "--bench-parallel-parse")
+            benchParallelParse = true;
+        else if (arg == "--bench-incremental")
+            benchIncremental = true;
+        else if (arg == "--watch")
+            watchMode = true;
+        else if (arg == "--bench-cache")
+            benchCache = true;
+        else if (arg == "--bench-compact")
+            benchCompact = true;
+        else if (arg == "--bench-visit")
+            benchVisit = true;
+        else if (arg == "--bench-eval")
+            benchEval = true;
+        else if (arg == "--ast-stats")
+            astStats = true;
+        else if (arg == "--ast-stats=json")
+            astStats = astStatsJson = true;
+        else if (arg == "--fold")
+            foldConstants = true;
+        else if (arg == "--eval")
+            evaluate = true;
+        else if (arg == "--engine=tree" || arg == "--engine=vm") {
+            evaluate = true;
+            useVm = arg == "--engine=vm";
+        }
+        else if (arg == "--compact")
+            compactMode = true;
+        else if (arg == "--share")
+            sharing = NodeSharing::LEAVES;
+        else if (arg == "--share=expressions")
+            sharing = NodeSharing::EXPRESSIONS;
+        else if (arg == "--cache")
+            cacheDir = ".compilatore-cache";
+        else if (arg.rfind("--cache=", 0) == 0)
+            cacheDir = arg.substr(std::strlen("--cache="));
+        else if (arg.rfind("--lex-threads=", 0) == 0)
+            lexThreads = static_cast<unsigned>(std::atoi(arg.c_str() + std::strlen("--lex-threads=")));
+        else if (arg.rfind("--parse-threads=", 0) == 0)
+            parseThreads = static_cast<unsigned>(std::atoi(arg.c_str() + std::strlen("--parse-threads=")));
+        else if (arg == "--stream")
+            streamMode = true;
+        else if (arg == "--lazy")
+            lazyParse = true;
+        else
+            fileName = arg;
     }
 
-    // Opening input file
-    std::ifstream inputFile;
-    try {
-        inputFile.open(argv[1]);
+    if (benchKeywords) {
+        Benchmark::keywords();
+        return EXIT_SUCCESS;
     }
-    catch (std::exception const& exc) {
-        std::cerr << "Cannot open " << argv[1] << std::endl;
-        std::cerr << exc.what() << std::endl;
+
+    // in modalita' streaming l'input puo' essere lo standard input
+    if (streamMode && fileName.empty())
+        fileName = "-";
+
+    if (fileName.empty()) {
+        std::cerr << "File not found!" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " [--bench-lex | --bench-scan | --bench-keywords | --bench-parallel-lex | --bench-parse | --bench-parallel-parse | --bench-incremental | --bench-cache | --bench-compact | --bench-visit | --bench-eval]"
+                  << " [--stream | --lex-threads=N] [--lazy] [--parse-threads=N] [--compact] [--share[=expressions]] [--fold] [--eval | --engine=tree|vm] [--ast-stats[=json]] [--watch] [--cache[=DIR]]"
+                  << " <file_name | ->" << std::endl;
         return EXIT_FAILURE;
     }
 
-    // Lexical analysis
-    Tokenizer tokenize;
-    std::vector<Token> inputTokens;
-    try {
-        inputTokens = std::move(tokenize(inputFile));
-        inputFile.close();
+    if (benchLex || benchScan || benchParallelLex || benchParse || benchParallelParse || benchIncremental
+        || benchCache || benchCompact || benchVisit || benchEval) {
+        try {
+            if (benchLex)
+                Benchmark::lexer(fileName);
+            if (benchScan)
+                Benchmark::scanKernels(fileName);
+            if (benchParallelLex)
+                Benchmark::parallelLexer(fileName);
+            if (benchParse)
+                Benchmark::parser(fileName);
+            if (benchParallelParse)
+                Benchmark::parallelParser(fileName);
+            if (benchIncremental)
+                Benchmark::incremental(fileName);
+            if (benchCache)
+                Benchmark::compileCache(fileName);
+            if (benchCompact)
+                Benchmark::compactAst(fileName);
+            if (benchVisit)
+                Benchmark::visitors(fileName);
+            if (benchEval)
+                Benchmark::evaluator(fileName);
+        }
+        catch (std::exception const& exc) {
+            std::cerr << exc.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
     }
-    catch (LexicalError const& le) {
-        std::cerr << "Lexical error" << std::endl;
-        std::cerr << le.what() << std::endl;
-        return EXIT_FAILURE;
+
+    if (watchMode)
+        return watch(fileName);
+
+    // Con --cache si cerca prima l'immagine del programma gia' analizzato:
+    // se c'e', token e AST vengono letti direttamente dall'immagine mappata
+    // e con --engine=vm il programma viene eseguito dal bytecode che vi e'
+    // salvato. --fold, --ast-stats e l'interprete ad albero lavorano sui
+    // nodi dell'AST, che l'immagine non contiene
+    const bool needsNodes = foldConstants || evaluate || astStats;
+    bool useCache = !cacheDir.empty() && !streamMode && !foldConstants && !astStats && (!evaluate || useVm);
+    CompileCache cache{ cacheDir };
+    std::uint64_t sourceHash = 0;
+    SourceBuffer source = SourceBuffer::fromMemory({});
+    if (useCache) {
+        try {
+            source = SourceBuffer{ fileName };
+        }
+        catch (std::exception const& exc) {
+            std::cerr << "Cannot read from " << fileName << std::endl;
+            std::cerr << exc.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        sourceHash = CompileCache::hash(source.data(), source.size());
+
+        // un'immagine salvata senza --eval non ha il bytecode: viene
+        // sostituita da quella prodotta analizzando di nuovo il sorgente
+        CompileCache::Entry entry;
+        if (cache.lookup(sourceHash, source.size(), entry) && (!evaluate || entry.image.hasBytecode())) {
+            for (const Token* token = entry.image.tokensBegin(); token != entry.image.tokensEnd(); ++token)
+                std::cout << token->tag << " " << std::string_view(source.data() + token->offset, token->length) << std::endl;
+            std::cout << "L'espressione letta è ";
+            ProgramImage::print(entry.image, std::cout);
+            std::cout << std::endl;
+            if (evaluate) {
+                try {
+                    VirtualMachine vm(std::cout);
+                    vm.run(entry.image.bytecode());
+                }
+                catch (EvaluationError const& ee) {
+                    std::cerr << "Errore nella valutazione" << std::endl;
+                    std::cerr << ee.what() << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+            return EXIT_SUCCESS;
+        }
     }
-    catch (std::exception const& exc) {
-        std::cerr << "Cannot read from " << argv[1] << std::endl;
-        std::cerr << exc.what() << std::endl;
-        return EXIT_FAILURE;
+
+    // Lexical analysis (il file viene letto come un unico buffer)
+    Tokenizer tokenize{ lexThreads };
+    TokenStream inputTokens;
+    if (!streamMode) {
+        try {
+            inputTokens = useCache ? tokenize(std::move(source)) : tokenize(fileName);
+        }
+        catch (LexicalError const& le) {
+            std::cerr << "Lexical error" << std::endl;
+            std::cerr << le.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        catch (std::exception const& exc) {
+            std::cerr << "Cannot read from " << fileName << std::endl;
+            std::cerr << exc.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // con --ast-stats si stampano solo le statistiche
+        if (!astStats)
+            for(const Token& token : inputTokens)
+            {
+                std::cout<<token.tag<<" "<<inputTokens.spelling(token)<<std::endl;
+            }
     }
 
-    for(int i = 0; i<inputTokens.size(); i++)
-    {
-        std::cout<<inputTokens[i].tag<<" "<<inputTokens[i].word<<std::endl;
+    // Con --stream i token vengono invece prodotti durante il parsing,
+    // leggendo l'input a blocchi
+    std::ifstream inputFile;
+    std::unique_ptr<StreamLexer> streamLexer;
+    TokenSource* tokenSource = &inputTokens;
+    if (streamMode) {
+        std::istream* in = &std::cin;
+        if (fileName != "-") {
+            inputFile.open(fileName, std::ios::in | std::ios::binary);
+            if (!inputFile) {
+                std::cerr << "Cannot open " << fileName << std::endl;
+                return EXIT_FAILURE;
+            }
+            in = &inputFile;
+        }
+        streamLexer = std::make_unique<StreamLexer>(*in);
+        tokenSource = streamLexer.get();
     }
 
     // Analisi sinttattica
-    ExpressionManager manager;
-    Parser parser(manager, inputTokens);
+    ExpressionManager manager{ sharing };
     Program* program = nullptr;
+    CompactAst compactProgram;
+    compactMode = compactMode && !streamMode && !needsNodes;
     try {
-        program = parser();
+        // il parsing pigro e quello parallelo richiedono tutti i token in memoria
+        if (compactMode) {
+            CompactParser parser(compactProgram, inputTokens);
+            parser();
+        }
+        else if (!streamMode) {
+            Parser parser(manager, inputTokens,
+                          lazyParse ? ParseMode::LAZY : ParseMode::STRICT, parseThreads);
+            program = parser();
+        }
+        else {
+            Parser parser(manager, *tokenSource);
+            program = parser();
+        }
+    }
+    catch (LexicalError const& le) {
+        std::cerr << "Lexical error" << std::endl;
+        std::cerr << le.what() << std::endl;
+        return EXIT_FAILURE;
     }
     catch (ParseError const& pe) {
         std::cerr << "Parse error" << std::endl;
@@ -74,13 +356,61 @@ int main(int argc, char* argv[]) {
 
     // Valutazione (Analisi semantica)
     try {
+        if (astStats) {
+            AstStats stats = AstStats::collect(program, manager);
+            if (astStatsJson)
+                stats.printJson(std::cout);
+            else
+                stats.print(std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        if (foldConstants) {
+            ConstantFolder folder(manager);
+            folder.fold(program);
+        }
+
         PrintVisitor* p = new PrintVisitor();
         std::cout << "L'espressione letta è ";
-        program->accept(p);
+        if (compactMode)
+            print(compactProgram, std::cout);
+        else
+            program->accept(p);
         std::cout << std::endl;
-        /*EvaluationVisitor* v = new EvaluationVisitor();
-        expr->accept(v);
-        std::cout << "Il valore dell'espressione è " << v->getValue() << std::endl;*/
+
+        // i nomi non dichiarati vengono segnalati prima di eseguire
+        Bytecode bytecode;
+        if (evaluate) {
+            Resolver resolver(manager);
+            resolver.resolve(program);
+            if (useVm)
+                bytecode = BytecodeCompiler{}.compile(program);
+        }
+
+        // l'immagine si salva solo per i programmi analizzati senza errori,
+        // con il bytecode se e' stato compilato
+        if (useCache && program && !cache.store(sourceHash,
+                ProgramImage::build(program, inputTokens, CompileCache::compilerHash(), sourceHash,
+                                    evaluate ? &bytecode : nullptr)))
+            std::cerr << "Cannot write to cache directory " << cacheDir << std::endl;
+
+        if (evaluate) {
+            if (useVm) {
+                VirtualMachine vm(std::cout);
+                vm.run(bytecode);
+            }
+            else {
+                EvaluationVisitor evaluator(std::cout);
+                evaluator.run(program);
+            }
+        }
+    }
+    // con --lazy i blocchi annidati vengono analizzati durante la visita
+    catch (ParseError const& pe) {
+        std::cout << std::endl;
+        std::cerr << "Parse error" << std::endl;
+        std::cerr << pe.what() << std::endl;
+        return EXIT_FAILURE;
     }
     catch (EvaluationError const& ee) {
         std::cerr << "Errore nella valutazione" << std::endl;
@@ -1,145 +1,43 @@
-#include "Node.h"
-
-
-void Expression::accept(Visitor* v){
-    throw EvaluationError("accept method of Expression didn't get redefined in subclass");
-}
-
-
-void Unary::accept(Visitor* v)
-{
-    v->visitUnaryOp(this);
-}
-
-void Arithm::accept(Visitor* v)
-{
-    v->visitBinOp(this);
-}
-
-void Access::accept(Visitor* v)
-{
-    v->visitAccess(this);
-}
-
-void If::accept(Visitor* v)
-{
-    v->visitIf(this);
-}
-
-void Else::accept(Visitor* v)
-{
-    v->visitElse(this);
-}
-
-void While::accept(Visitor* v)
-{
-    v->visitWhile(this);
-}
-
-void Do::accept(Visitor* v)
-{
-    v->visitDo(this);
-}
-
-void Set::accept(Visitor* v)
-{
-    v->visitSet(this);
-}
-
-void SetElem::accept(Visitor* v)
-{
-    v->visitSetElem(this);
-}
-
-void Break::accept(Visitor* v)
-{
-    v->visitBreak(this);
-}
-
-void Print::accept(Visitor* v)
-{
-    v->visitPrint(this);
-}
-
-void Id::accept(Visitor* v)
-{
-    v->visitId(this);
-}
-
-void intConstant::accept(Visitor* v)
-{
-    v->visitIntConstant(this);
-}
-void boolConstant::accept(Visitor* v)
-{
-    v->visitBoolConstant(this);
-}
-
-
-//Logical
-void Not::accept(Visitor* v)
-{
-    v->visitNot(this);
-}
-void And::accept(Visitor* v)
-{
-    v->visitAnd(this);
-}
-void Rel::accept(Visitor* v)
-{
-    v->visitRel(this);
-}
-
-void Or::accept(Visitor* v)
-{
-    v->visitOr(this);
-}
-
-//Decls
-void Decls::accept(Visitor* v) {
-    v->visitDecls(this);
-}
-
-void Decl::accept(Visitor* v){
-    v->visitDecl(this);
-}
-
-//Block
-void Block::accept(Visitor* v)
-{
-    v->visitBlock(this);
-}
-
-//Type
-void Type::accept(Visitor* v) {
-    v->visitType(this);
-}
-
-void vectorType::accept(Visitor* v) {
-    v->visitVectorType(this);
-}
-
-//Stmt
-void Stmts::accept(Visitor* v) {
-    v->visitStmts(this);
-}
-
-//Stmt should not 
-void Stmt::accept(Visitor* v) {
-    throw EvaluationError("accept method of Stmt didn't get redefined in subclass");
-}
-
-
-
-void Program::accept(Visitor* v)
-{
-    v->visitProgram(this);
-}
-
-
-std::string Type::typeid2String[Type::numOfTypes] = {"int","bool"};
-
-std::string Rel::opCode2String[Rel::numOfOps] = {">",">=","<","<="};
-
-std::string Op::binOp2String[Op::numOfBinOps] = {"+","-","*","/","==","!="};
+#include "Node.h"
+
+
+//Lo switch sul tipo sostituisce le funzioni virtuali dei singoli nodi
+void Node::accept(Visitor* v)
+{
+    switch(kind)
+    {
+        case NodeKind::PROGRAM: v->visitProgram(static_cast<Program*>(this)); break;
+        case NodeKind::BLOCK: v->visitBlock(static_cast<Block*>(this)); break;
+        case NodeKind::TYPE: v->visitType(static_cast<Type*>(this)); break;
+        case NodeKind::VECTOR_TYPE: v->visitVectorType(static_cast<vectorType*>(this)); break;
+        case NodeKind::DECLS: v->visitDecls(static_cast<Decls*>(this)); break;
+        case NodeKind::DECL: v->visitDecl(static_cast<Decl*>(this)); break;
+        case NodeKind::ID: v->visitId(static_cast<Id*>(this)); break;
+        case NodeKind::STMTS: v->visitStmts(static_cast<Stmts*>(this)); break;
+        case NodeKind::INT_CONSTANT: v->visitIntConstant(static_cast<intConstant*>(this)); break;
+        case NodeKind::BOOL_CONSTANT: v->visitBoolConstant(static_cast<boolConstant*>(this)); break;
+        case NodeKind::BIN_OP: v->visitBinOp(static_cast<Arithm*>(this)); break;
+        case NodeKind::UNARY_OP: v->visitUnaryOp(static_cast<Unary*>(this)); break;
+        case NodeKind::ACCESS: v->visitAccess(static_cast<Access*>(this)); break;
+        case NodeKind::IF: v->visitIf(static_cast<If*>(this)); break;
+        case NodeKind::ELSE: v->visitElse(static_cast<Else*>(this)); break;
+        case NodeKind::WHILE: v->visitWhile(static_cast<While*>(this)); break;
+        case NodeKind::DO: v->visitDo(static_cast<Do*>(this)); break;
+        case NodeKind::SET: v->visitSet(static_cast<Set*>(this)); break;
+        case NodeKind::SET_ELEM: v->visitSetElem(static_cast<SetElem*>(this)); break;
+        case NodeKind::BREAK: v->visitBreak(static_cast<Break*>(this)); break;
+        case NodeKind::PRINT: v->visitPrint(static_cast<Print*>(this)); break;
+        case NodeKind::NOT: v->visitNot(static_cast<Not*>(this)); break;
+        case NodeKind::AND: v->visitAnd(static_cast<And*>(this)); break;
+        case NodeKind::OR: v->visitOr(static_cast<Or*>(this)); break;
+        case NodeKind::REL: v->visitRel(static_cast<Rel*>(this)); break;
+    }
+}
+
+
+std::string Type::typeid2String[Type::numOfTypes] = {"int","bool"};
+
+std::string Rel::opCode2String[Rel::numOfOps] = {">",">=","<","<="};
+
+std::string Op::binOp2String[Op::numOfBinOps] = {"+","-","*","/","==","!="};
 std::string Op::unaryOp2String[Op::numOfUnaryOps] = {"-"};
\ No newline at end of file
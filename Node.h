@@ -1,8 +1,13 @@
 #ifndef NODE_H
 #define NODE_H
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
 
+#include "Atoms.h"
+
 //forward declaration essenziali per evitare errori di compilazipone
 class Visitor;  
 class Id;
@@ -10,12 +15,33 @@ class Stmts;
 class Stmt;
 class Block;
 
+//Tipo concreto di un nodo: il metodo di visita si sceglie con uno switch
+//su di esso (vedi dispatch in fondo al file e Node::accept in Visitor.h)
+//invece che con funzioni virtuali, che i nodi non hanno
+enum class NodeKind : std::uint8_t {
+    PROGRAM, BLOCK, TYPE, VECTOR_TYPE, DECLS, DECL, ID, STMTS,
+    INT_CONSTANT, BOOL_CONSTANT, BIN_OP, UNARY_OP, ACCESS,
+    IF, ELSE, WHILE, DO, SET, SET_ELEM, BREAK, PRINT,
+    NOT, AND, OR, REL
+};
+
+constexpr std::size_t numOfNodeKinds = static_cast<std::size_t>(NodeKind::REL) + 1;
+
 class Node
 {
     public:
-    virtual ~Node() = default;
-    Node() = default;
-    virtual void accept(Visitor* v) = 0;
+    NodeKind getKind() const {return kind;}
+
+    //visita con il Visitor astratto (adattatore per i visitor esistenti)
+    void accept(Visitor* v);
+
+    protected:
+    explicit Node(NodeKind k) : kind{k} {}
+    //i nodi vengono liberati dall'ExpressionManager senza distruggerli
+    ~Node() = default;
+
+    private:
+    NodeKind kind;
 };
 
 //Type
@@ -27,12 +53,12 @@ public:
     static const int numOfTypes = 2;
     static std::string  typeid2String [numOfTypes]; 
 
-    Type(TypeCode t) : type{t}{}
+    Type(TypeCode t) : Node(NodeKind::TYPE), type{t}{}
 
     TypeCode getType() {return type;}
     
-
-    void accept(Visitor* v) override;   
+protected:
+    Type(NodeKind k, TypeCode t) : Node(k), type{t}{}
 
 private:
 
@@ -43,11 +69,10 @@ private:
 class vectorType : public Type{
 public: 
 
-    vectorType(Type::TypeCode t, int s) : Type(t), size{s}{}
+    vectorType(Type::TypeCode t, int s) : Type(NodeKind::VECTOR_TYPE, t), size{s}{}
     
     int getSize(){return size;}
 
-    void accept(Visitor* v) override;   
 
 private:
     int size;
@@ -59,31 +84,35 @@ private:
 class Decl : public Node{
 public:
 
-    Decl(Type* t, Id* i): type{t}, id{i}{}
+    Decl(Type* t, Id* i): Node(NodeKind::DECL), type{t}, id{i}{}
     Type* getType(){return type;}
     Id* getId(){return id;}
+    void setId(Id* i){id = i;}
 
-    void accept(Visitor* v) override;
 private:
     Type* type;
     Id* id;
 };
 
+// Le dichiarazioni di un blocco sono memorizzate in un array contiguo
+// (allocato dall'ExpressionManager) anziche' in una lista concatenata
 class Decls : public Node{
 public:
 
     //la definizione di decls vuoto non è compito dell'user della classe 
     static constexpr Decls* EMPTY_DECLS = nullptr; 
-    Decls(Decl* dec, Decls* decs ): declaration{dec}, declarations{decs}{}
+    Decls(Decl** decs, std::size_t count): Node(NodeKind::DECLS), declarations{decs}, size{count}{}
+
+    std::size_t getSize(){return size;}
+    Decl* getDecl(std::size_t i){return declarations[i];}
 
-    Decl* getDecl(){return declaration;}
-    Decls* getDecls(){return declarations;}
+    Decl** begin(){return declarations;}
+    Decl** end(){return declarations + size;}
 
-    void accept(Visitor* v) override;
 
 private:
-    Decl* declaration;
-    Decls* declarations; 
+    Decl** declarations;
+    std::size_t size;
 };
 
 
@@ -92,28 +121,31 @@ private:
 class Program : public Node{
 public:
 
-    Program(Block* b) : block{b}{}
+    Program(Block* b) : Node(NodeKind::PROGRAM), block{b}{}
 
     Block* getBlock() {return block;}
-    
-    void accept(Visitor* v) override;
+
+    //celle necessarie a tutte le variabili (assegnato da Resolver)
+    std::uint32_t getFrameSize() const {return frameSize;}
+    void setFrameSize(std::uint32_t size) {frameSize = size;}
 
 private:
     Block* block;
+    std::uint32_t frameSize = 0;
 };
 
 
 
 //Expression
 class Expression : public Node{
-public:
-    void accept(Visitor* v) override;
+protected:
+    explicit Expression(NodeKind k) : Node(k){}
 };
     
 class Constant : public Expression {
     
 public: 
-    Constant(Type::TypeCode t) : typeCode{t}{}
+    Constant(NodeKind k, Type::TypeCode t) : Expression(k), typeCode{t}{}
 
 private:
     Type::TypeCode typeCode;
@@ -123,29 +155,40 @@ private:
 class Id: public Expression
 {
 public:
-  Id(std::string name_) : name{name_} {};
+  //il nome e' l'atomo della tabella globale (AtomTable)
+  Id(Atom name_) : Expression(NodeKind::ID), name{name_} {};
   Id& operator= (const Id& other) = default;
   
-  std::string getName() {
+  std::string_view getName() {
+    return AtomTable::global().spelling(name);
+  }
+
+  Atom getAtom() const {
     return name;
   }
 
-  void accept(Visitor* v) override;
+  //dichiarazione a cui si riferisce il nome e prima cella della variabile
+  //nel frame del programma (assegnate da Resolver; nullptr prima)
+  Decl* getDecl() const {return decl;}
+  std::uint32_t getSlot() const {return slot;}
+  void resolve(Decl* d, std::uint32_t s) {decl = d; slot = s;}
+
 
 private:
-  std::string name; 
+  Atom name; 
+  std::uint32_t slot = 0;
+  Decl* decl = nullptr;
 };
 
 class intConstant : public Constant{
 public:
 
-    intConstant(int v) : value{v}, Constant(Type::INT){}
+    intConstant(int v) : Constant(NodeKind::INT_CONSTANT, Type::INT), value{v}{}
 
     int getValue () const  {
         return value;
     }
 
-    void accept(Visitor* v) override;
 
 private:
     int value;
@@ -154,13 +197,12 @@ private:
 class boolConstant : public Constant{
 public:
     
-    boolConstant(bool v) : value{v}, Constant(Type::BOOL) {}
+    boolConstant(bool v) : Constant(NodeKind::BOOL_CONSTANT, Type::BOOL), value{v} {}
     
     bool getValue() const  {
         return value;
     }
 
-    void accept(Visitor* v) override;
 
 private:
     bool value;
@@ -169,17 +211,17 @@ private:
 
 //Logical
 class Logical : public Expression{
-
+protected:
+    explicit Logical(NodeKind k) : Expression(k){}
 };
 
 class Not : public Logical{
 
 public:
 
-    Not(Expression* e) : exp{e}{}
+    Not(Expression* e) : Logical(NodeKind::NOT), exp{e}{}
     Expression* getExp() {return exp;}
 
-    void accept(Visitor* v) override;
 
 private:
     Expression* exp;
@@ -190,11 +232,10 @@ class And : public Logical{
 
 public:
 
-    And(Expression* l, Expression* r) : left{l}, right{r}{}
+    And(Expression* l, Expression* r) : Logical(NodeKind::AND), left{l}, right{r}{}
     Expression* getLeftExp() {return left;}
     Expression* getRightExp() {return right;}
 
-    void accept(Visitor* v) override;
 
 private:
     Expression* left;
@@ -206,11 +247,10 @@ class Or : public Logical{
 
 public:
 
-    Or(Expression* l, Expression* r) : left{l}, right{r}{}
+    Or(Expression* l, Expression* r) : Logical(NodeKind::OR), left{l}, right{r}{}
     Expression* getLeftExp() {return left;}
     Expression* getRightExp() {return right;}
 
-    void accept(Visitor* v) override;
 
 
 private:
@@ -226,12 +266,11 @@ public:
     static std::string opCode2String[numOfOps];
 
     Rel(Expression* l, Expression* r, OpCode op) :
-    left{l}, right{r}, operation{op}{}
+    Logical(NodeKind::REL), left{l}, right{r}, operation{op}{}
     Expression* getLeftExp() {return left;}
     Expression* getRightExp() {return right;}
     OpCode getOp(){return operation;} 
 
-    void accept(Visitor* v) override;
 
 private:
     Expression* left;
@@ -253,20 +292,22 @@ public:
   enum UnaryOpCode {UNARY_MIN};
   static const int numOfUnaryOps = 1; 
   static std::string unaryOp2String[numOfUnaryOps];
+
+protected:
+  explicit Op(NodeKind k) : Expression(k){}
 };
 
 //operatori unari
 class Unary : public Op{
 
 public:
-    Unary( Expression* ex, UnaryOpCode op) : exp{ex}, operation{op} {}
+    Unary( Expression* ex, UnaryOpCode op) : Op(NodeKind::UNARY_OP), exp{ex}, operation{op} {}
 
     //dato che al momento c'è solo un'operazione unaria la si assegna automaticamente
-    Unary (Expression* ex) : exp{ex} {operation = UNARY_MIN;}
+    Unary (Expression* ex) : Op(NodeKind::UNARY_OP), exp{ex} {operation = UNARY_MIN;}
     Expression* getExp() {return exp;}
     UnaryOpCode getOp(){return operation;} 
 
-    void accept(Visitor* v) override;
 
 private:
     Expression* exp;
@@ -280,12 +321,11 @@ class Arithm : public Op{
 public:
 
     Arithm(Expression* l, Expression* r, BinOpCode op) :
-    left{l}, right{r}, operation{op}{} 
+    Op(NodeKind::BIN_OP), left{l}, right{r}, operation{op}{} 
     Expression* getLeftExp() {return left;}
     Expression* getRightExp() {return right;}
     BinOpCode getOp() {return operation;} 
 
-    void accept(Visitor* v) override;
 
 private:
     Expression* left;
@@ -297,11 +337,11 @@ private:
 class Access : public Op{
 public:
 
-    Access(Id* vec, Expression* ind) : vector{vec}, index{ind}{}
+    Access(Id* vec, Expression* ind) : Op(NodeKind::ACCESS), vector{vec}, index{ind}{}
     Id* getId() {return vector;}
     Expression* getIndex() {return index;}
+    std::uint32_t getSlot() {return vector->getSlot();}
 
-    void accept(Visitor* v) override;
 
 private:
     Id* vector;
@@ -312,38 +352,40 @@ private:
 
 
 //Stmts
+//Come Decls, gli statement di un blocco sono un array contiguo
 class Stmts: public Node{
 public:
 
 static constexpr Stmts* EMPTY_STMTS = nullptr; 
-Stmts(Stmts* stmts_, Stmt* stmt_) : stmts{stmts_}, stmt{stmt_}{}
+Stmts(Stmt** stmts_, std::size_t count) : Node(NodeKind::STMTS), statements{stmts_}, size{count}{}
 
-Stmts* getStmts() {return stmts;}
-Stmt* getStmt() {return stmt;}
+std::size_t getSize() {return size;}
+Stmt* getStmt(std::size_t i) {return statements[i];}
+
+Stmt** begin() {return statements;}
+Stmt** end() {return statements + size;}
 
-void accept(Visitor* v) override;   
 
 private:
-Stmts* stmts;
-Stmt* stmt;
+Stmt** statements;
+std::size_t size;
 };
 
 class Stmt : public Node{
   
-public:
-    void accept(Visitor* v) override;   
-
+protected:
+    explicit Stmt(NodeKind k) : Node(k){}
 };
 
 class If : public Stmt {
 public:
 
-    If(Stmt* s, Expression* e) : stmt{s}, condition{e}{}
+    If(Stmt* s, Expression* e) : Stmt(NodeKind::IF), stmt{s}, condition{e}{}
 
     Stmt* getStmt() {return stmt;}
     Expression* getCondition () {return condition;}
+    void setCondition(Expression* e) {condition = e;}
 
-    void accept(Visitor* v) override;   
 
 private:
     Stmt* stmt;
@@ -354,13 +396,13 @@ class Else : public Stmt{
 public:
 
     Else(Stmt* stmtTrue, Stmt* stmtFalse, Expression* e)
-     : stmtIfTrue{stmtTrue}, stmtIfFalse{stmtFalse}, condition{e}{}
+     : Stmt(NodeKind::ELSE), stmtIfTrue{stmtTrue}, stmtIfFalse{stmtFalse}, condition{e}{}
 
     Stmt* getifTrueStmt() {return stmtIfTrue;}
     Stmt* getifFalseStmt() {return stmtIfFalse;}
     Expression* getCondition () {return condition;}
+    void setCondition(Expression* e) {condition = e;}
 
-    void accept(Visitor* v) override;   
 
 private:
     Expression* condition;
@@ -371,13 +413,13 @@ private:
 class While : public Stmt{
 public:
 
-    While(Stmt* s, Expression* e) : stmt{s}, condition{e}{}
+    While(Stmt* s, Expression* e) : Stmt(NodeKind::WHILE), stmt{s}, condition{e}{}
     
     Stmt* getStmt() {return stmt;}
     Expression* getCondition () {return condition;}
+    void setCondition(Expression* e) {condition = e;}
 
  
-    void accept(Visitor* v) override;   
 
 private:
     Stmt* stmt;
@@ -387,12 +429,12 @@ private:
 class Do : public Stmt{
 public:
 
-    Do(Stmt* s, Expression* e) : stmt{s}, condition{e}{}
+    Do(Stmt* s, Expression* e) : Stmt(NodeKind::DO), stmt{s}, condition{e}{}
     Stmt* getStmt() {return stmt;}
     Expression* getCondition () {return condition;}
+    void setCondition(Expression* e) {condition = e;}
 
 
-    void accept(Visitor* v) override;   
 
 private:
     Stmt* stmt;
@@ -403,11 +445,13 @@ private:
 class Set : public Stmt{
 public:
 
-    Set(Id* var, Expression* e) : variable{var}, exp{e}{}
+    Set(Id* var, Expression* e) : Stmt(NodeKind::SET), variable{var}, exp{e}{}
     Id* getId(){return variable;}
     Expression* getExp(){return exp;}
+    void setExp(Expression* e){exp = e;}
+    void setId(Id* var){variable = var;}
+    std::uint32_t getSlot(){return variable->getSlot();}
 
-    void accept(Visitor* v) override;   
 
 private:
     Id* variable;
@@ -418,14 +462,17 @@ class SetElem : public Stmt{
 public:
 
     SetElem(Id* v, Expression* e, Expression* i) :
-         arrayName{v}, exp{e}, index{e} {}
+         Stmt(NodeKind::SET_ELEM), arrayName{v}, exp{e}, index{i} {}
 
     Id* getId(){return arrayName;}
     Expression* getExp(){return exp;}
     Expression* getIndex(){return index;}
+    void setExp(Expression* e){exp = e;}
+    void setIndex(Expression* i){index = i;}
+    void setId(Id* v){arrayName = v;}
+    std::uint32_t getSlot(){return arrayName->getSlot();}
 
 
-    void accept(Visitor* v) override;   
 
 
 private:
@@ -436,39 +483,108 @@ private:
 
 class Break : public Stmt{
 public:
-    Break() = default;
-    void accept(Visitor* v) override;   
+    Break() : Stmt(NodeKind::BREAK) {}
 
 };
 
 class Print : public Stmt{
 public:
 
-    Print(Expression* e) : expToPrint{e}{}
+    Print(Expression* e) : Stmt(NodeKind::PRINT), expToPrint{e}{}
     Expression* getExp(){return expToPrint;}
+    void setExp(Expression* e){expToPrint = e;}
    
-    void accept(Visitor* v) override;   
 
 private:
     Expression* expToPrint;    
 };
 
+//Chi sa analizzare il corpo di un blocco rimandato (parsing pigro)
+class BlockLoader {
+public:
+    virtual ~BlockLoader() = default;
+    //analizza il corpo del blocco e lo assegna con Block::setContents
+    virtual void load(Block* block) = 0;
+};
+
 class Block : public Stmt{
 public:
 
-    Block(Decls* decs, Stmts* stmts) : declarations{decs}, statements{stmts}{}
-    Decls* getDecls(){return declarations;}
-    Stmts* getStmts(){return statements;}
+    Block(Decls* decs, Stmts* stmts) : Stmt(NodeKind::BLOCK), declarations{decs}, statements{stmts}{}
+
+    //blocco di cui si conosce solo l'intervallo di token [first, last]
+    //(dalla '{' alla '}'): il corpo viene analizzato al primo accesso
+    Block(BlockLoader* l, std::uint32_t first, std::uint32_t last)
+     : Stmt(NodeKind::BLOCK), declarations{nullptr}, statements{nullptr}, loader{l}, firstToken{first}, lastToken{last}{}
+
+    Decls* getDecls(){load(); return declarations;}
+    Stmts* getStmts(){load(); return statements;}
+
+    bool isLoaded() const {return loader == nullptr;}
+    std::uint32_t getFirstToken() const {return firstToken;}
+    std::uint32_t getLastToken() const {return lastToken;}
+
+    void setContents(Decls* decs, Stmts* stmts){
+        declarations = decs;
+        statements = stmts;
+        loader = nullptr;
+    }
 
-    void accept(Visitor* v) override;   
 
 private:
+    void load(){
+        if(loader)
+            loader->load(this);
+    }
+
     Decls* declarations;
     Stmts* statements;
 
+    BlockLoader* loader = nullptr;
+    std::uint32_t firstToken = 0;
+    std::uint32_t lastToken = 0;
 };
 
 
+//Chiama f con il nodo convertito al suo tipo concreto. A differenza di
+//Node::accept non passa per un Visitor, quindi f (di solito una lambda
+//generica) puo' essere espansa inline nello switch. Tutti i rami devono
+//restituire lo stesso tipo.
+template <typename F>
+decltype(auto) dispatch(Node* node, F&& f)
+{
+    switch(node->getKind())
+    {
+        case NodeKind::PROGRAM: return f(static_cast<Program*>(node));
+        case NodeKind::BLOCK: return f(static_cast<Block*>(node));
+        case NodeKind::TYPE: return f(static_cast<Type*>(node));
+        case NodeKind::VECTOR_TYPE: return f(static_cast<vectorType*>(node));
+        case NodeKind::DECLS: return f(static_cast<Decls*>(node));
+        case NodeKind::DECL: return f(static_cast<Decl*>(node));
+        case NodeKind::ID: return f(static_cast<Id*>(node));
+        case NodeKind::STMTS: return f(static_cast<Stmts*>(node));
+        case NodeKind::INT_CONSTANT: return f(static_cast<intConstant*>(node));
+        case NodeKind::BOOL_CONSTANT: return f(static_cast<boolConstant*>(node));
+        case NodeKind::BIN_OP: return f(static_cast<Arithm*>(node));
+        case NodeKind::UNARY_OP: return f(static_cast<Unary*>(node));
+        case NodeKind::ACCESS: return f(static_cast<Access*>(node));
+        case NodeKind::IF: return f(static_cast<If*>(node));
+        case NodeKind::ELSE: return f(static_cast<Else*>(node));
+        case NodeKind::WHILE: return f(static_cast<While*>(node));
+        case NodeKind::DO: return f(static_cast<Do*>(node));
+        case NodeKind::SET: return f(static_cast<Set*>(node));
+        case NodeKind::SET_ELEM: return f(static_cast<SetElem*>(node));
+        case NodeKind::BREAK: return f(static_cast<Break*>(node));
+        case NodeKind::PRINT: return f(static_cast<Print*>(node));
+        case NodeKind::NOT: return f(static_cast<Not*>(node));
+        case NodeKind::AND: return f(static_cast<And*>(node));
+        case NodeKind::OR: return f(static_cast<Or*>(node));
+        case NodeKind::REL:
+        default: return f(static_cast<Rel*>(node));
+    }
+}
+
+
 #include "Visitor.h"
 
 
@@ -1,6 +1,62 @@
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
 
 #include "Parser.h"
+#include "BinaryOperators.h"
+
+
+Parser::Parser(ExpressionManager& manager, TokenStream& tokens, ParseMode mode,
+               unsigned numThreads)
+ : Parser{ manager, static_cast<TokenSource&>(tokens) }
+{
+    tokenStream = &tokens;
+    tokensBegin = tokens.getTokens().data();
+
+    bool parallel = numThreads > 1 && tokens.size() >= minParallelTokens;
+    if(mode != ParseMode::LAZY && !parallel)
+        return;
+
+    StructureIndex index(tokens);
+    if(!index.isValid())
+        return;
+
+    if(mode == ParseMode::LAZY)
+    {
+        lazyLoader = new LazyBlockLoader(em, tokens, std::move(index));
+        em.addLoader(std::unique_ptr<BlockLoader>(lazyLoader));
+        structure = &lazyLoader->getStructure();
+    }
+    else
+    {
+        ownStructure = std::move(index);
+        structure = &ownStructure;
+    }
+    if(parallel)
+        threads = numThreads;
+}
+
+Parser::Parser(ExpressionManager& manager, TokenStream& tokens,
+               LazyBlockLoader* loader, std::size_t firstToken)
+ : Parser{ manager, static_cast<TokenSource&>(tokens) }
+{
+    tokenStream = &tokens;
+    tokensBegin = tokens.getTokens().data();
+    tokenItr = tokensBegin + firstToken;
+    lazyLoader = loader;
+    if(lazyLoader)
+        structure = &lazyLoader->getStructure();
+}
+
+void LazyBlockLoader::load(Block* block)
+{
+    Parser parser(em, stream, this, block->getFirstToken());
+    parser.loadBlock(block);
+}
 
 
 Program* Parser::parseProgram()
@@ -9,24 +65,179 @@ Program* Parser::parseProgram()
 }
 
 
+// The declarations of the outermost block are parsed here; its statements
+// are split at the boundaries found by the StructureIndex into ranges of
+// about the same number of tokens, which a pool of threads parses, each
+// into its own ExpressionManager. The statements are then spliced back in
+// source order, so the AST is the same as the serial one.
+// The boundaries are exact for valid programs. If a range fails or does not
+// end exactly at its boundary, the statements of the ranges before it are
+// kept and the rest of the block is parsed serially from its start: the
+// error reported is then the first one in source order, as in parseProgram.
+Program* Parser::parseProgramParallel()
+{
+    if(tokenItr->tag != Token::LEFT_CURLY)
+        return parseProgram();
+
+    std::uint32_t close = structure->closing(0);
+    consumeToken(Token::LEFT_CURLY);
+    auto decls = parseDecls();
+
+    std::uint32_t first = tokenIndex();
+    const std::vector<std::uint32_t>& starts = structure->getStatementStarts();
+    std::size_t chunks = threads * chunksPerThread;
+    std::size_t chunkTokens = first < close ? (close - first) / chunks + 1 : 1;
+
+    std::vector<std::uint32_t> bounds{ first };
+    for(std::size_t i = 1; i < chunks; ++i)
+    {
+        std::uint64_t target = std::max<std::uint64_t>(bounds.back() + 1, first + i * chunkTokens);
+        auto cut = std::lower_bound(starts.begin(), starts.end(), target);
+        if(cut == starts.end() || *cut >= close)
+            break;
+        bounds.push_back(*cut);
+    }
+    bounds.push_back(close);
+    chunks = bounds.size() - 1;
+
+    std::vector<std::unique_ptr<ExpressionManager>> managers(chunks);
+    std::vector<std::vector<Stmt*>> parsed(chunks);
+    std::vector<char> complete(chunks, 0);
+    std::atomic<std::size_t> nextChunk{ 0 };
+
+    auto work = [&] {
+        for(std::size_t i = nextChunk++; i < chunks; i = nextChunk++)
+        {
+            managers[i] = std::make_unique<ExpressionManager>(em.getSharing());
+            try {
+                Parser parser(*managers[i], *tokenStream, lazyLoader, bounds[i]);
+                complete[i] = parser.parseStmtRange(bounds[i + 1], parsed[i]);
+            }
+            catch(...) {
+                //the error is reported by the serial parse of this range
+                complete[i] = 0;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned t = 1; t < threads && t < chunks; ++t)
+        workers.emplace_back(work);
+    work();
+    for(std::thread& worker : workers)
+        worker.join();
+
+    std::size_t mark = stmtScratch.size();
+    std::size_t resume = 0;
+    for(; resume < chunks && complete[resume]; ++resume)
+        stmtScratch.insert(stmtScratch.end(), parsed[resume].begin(), parsed[resume].end());
+    for(auto& manager : managers)
+        em.splice(*manager);
+
+    tokenItr = tokensBegin + bounds[resume];
+    auto stmts = finishStmts(mark);
+    Block* block = em.makeBlock(decls, stmts);
+    consumeToken(Token::RIGHT_CURLY);
+    return em.makeProgram(block);
+}
+
+bool Parser::parseStmtRange(std::size_t end, std::vector<Stmt*>& out)
+{
+    while(tokenIndex() < end)
+        out.push_back(parseStmt());
+    return tokenIndex() == end;
+}
+
+
 Block* Parser::parseBlock()
 {
+    //the span of a block precedes those of the blocks nested in it
+    std::size_t spanSlot = 0;
+    if(spanSink)
+    {
+        spanSlot = spanSink->size();
+        spanSink->push_back(BlockSpan{ nullptr, tokenIndex(), 0 });
+    }
+
     consumeToken(Token::LEFT_CURLY);
     auto decls = parseDecls();
     auto stmts = parseStmts();
     Block* block = em.makeBlock(decls, stmts);
+    if(spanSink)
+    {
+        (*spanSink)[spanSlot].block = block;
+        (*spanSink)[spanSlot].last = tokenIndex();
+    }
     consumeToken(Token::RIGHT_CURLY);
     return block;
 }
 
+// The body is skipped by jumping to the matching '}' found by the
+// structural pre-scan; it is parsed later by LazyBlockLoader::load.
+// The outermost block of the program is never deferred.
+Block* Parser::parseLazyBlock()
+{
+    std::uint32_t first = tokenIndex();
+    std::uint32_t last = lazyLoader->getStructure().closing(first);
+    if(last - first < minLazyTokens)
+        return parseBlock();
+
+    Block* block = em.makeLazyBlock(lazyLoader, first, last);
+    //the '}' is followed at least by END_OF_INPUT
+    tokenItr = tokensBegin + last + 1;
+    return block;
+}
+
+// The reusable blocks are sorted by position and the parser only moves
+// forward, so the candidates before the current token are dropped for good.
+Block* Parser::reuseBlock()
+{
+    std::uint32_t index = tokenIndex();
+    while(reuseItr != reuseEnd && reuseItr->first < index)
+        ++reuseItr;
+    if(reuseItr == reuseEnd || reuseItr->first != index)
+        return nullptr;
+
+    const BlockSpan& span = *reuseItr++;
+    if(spanSink)
+        spanSink->push_back(span);
+    //the '}' is followed at least by END_OF_INPUT
+    tokenItr = tokensBegin + span.last + 1;
+    return span.block;
+}
+
+void Parser::loadBlock(Block* block)
+{
+    consumeToken(Token::LEFT_CURLY);
+    auto decls = parseDecls();
+    auto stmts = parseStmts();
+    consumeToken(Token::RIGHT_CURLY);
+    block->setContents(decls, stmts);
+}
+
+// Statements are parsed with a loop, so the C++ stack depth does not grow
+// with the length of the block. They are collected on stmtScratch, which is
+// shared by all the open blocks: a nested block pushes above our mark and
+// pops back to it before we continue.
 Stmts* Parser::parseStmts()
 {
-    if(tokenItr->tag == Token::RIGHT_CURLY) //end of block reached
+    return finishStmts(stmtScratch.size());
+}
+
+Stmts* Parser::finishStmts(std::size_t mark)
+{
+    while(tokenItr->tag != Token::RIGHT_CURLY) //end of block reached
+    {
+        Stmt* stmt = parseStmt();
+        stmtScratch.push_back(stmt);
+    }
+
+    std::size_t count = stmtScratch.size() - mark;
+    if(count == 0)
         return Stmts::EMPTY_STMTS;
 
-    Stmt* stmt = parseStmt();
-    Stmts* stmts = parseStmts();
-    return em.makeStmts(stmts,stmt);
+    Stmts* stmts = em.makeStmts(stmtScratch.data() + mark, count);
+    stmtScratch.resize(mark);
+    return stmts;
 }
 
 Stmt* Parser::parseStmt()
@@ -112,6 +323,11 @@ Stmt* Parser::parseStmt()
 
         case Token::LEFT_CURLY:
         {
+            if(reuseItr != reuseEnd)
+                if(Block* block = reuseBlock())
+                    return block;
+            if(lazyLoader)
+                return parseLazyBlock();
             return parseBlock();
         }
 
@@ -125,13 +341,16 @@ Stmt* Parser::parseStmt()
 
 Decls* Parser::parseDecls()
 {
-    //if condition is true, decls is not null, so it contains at least one declaration
-    if(tokenItr->tag == Token::BOOL || tokenItr->tag == Token::INT)
-    {
-        Decl* decl = parseDecl();
-        return em.makeDecls(decl, parseDecls());
-    }
-    else return Decls::EMPTY_DECLS;
+    //declarations cannot contain blocks, so the scratch vector is never
+    //shared between two open lists
+    declScratch.clear();
+    while(tokenItr->tag == Token::BOOL || tokenItr->tag == Token::INT)
+        declScratch.push_back(parseDecl());
+
+    //if no declaration was found, decls is null
+    if(declScratch.empty())
+        return Decls::EMPTY_DECLS;
+    return em.makeDecls(declScratch.data(), declScratch.size());
 }
 
 Decl* Parser::parseDecl()
@@ -147,7 +366,7 @@ Id* Parser::parseId()
     if(tokenItr->tag != Token::ID)
         throw ParseError{"Expected identifier, not found"};
         
-    auto id = em.makeId(tokenItr->word);
+    auto id = em.makeId(static_cast<Atom>(tokenItr->value));
     safe_next();
     return id;
     
@@ -179,7 +398,7 @@ Type* Parser::parseType()
         if(tokenItr->tag != Token::NUM)
             throw ParseError{"Expected numeric constant, not found"};
         
-        Type* type = em.makeVectorType(typeCode, std::stoi(tokenItr->word));
+        Type* type = em.makeVectorType(typeCode, tokenItr->value);
         safe_next();    //skip number
         consumeToken(Token::RIGHT_SQUARE);  //skip bracket  
         return type;
@@ -189,132 +408,54 @@ Type* Parser::parseType()
 }
 
 
-//<bool> -> <bool> || <join> | <join> can be expressed in the following way:
-// <bool> -> <join> (|| <join>)*
-
-Expression* Parser::parseExpression()
-{
-    Expression* exp = parseAnd();
-    while(tokenItr->tag == Token::OR)
-    {
-        safe_next();
-        exp = em.makeOr(exp, parseAnd());
-    }
-    return exp;
-}
+using namespace BinaryOperators;
 
-Expression* Parser::parseAnd()
-{
-    Expression* exp = parseEquality();
-    while(tokenItr->tag == Token::OR)
-    {
-        safe_next();
-        exp = em.makeAnd(exp, parseEquality());
-    }
-    return exp;
-    
-}
 
-Expression* Parser::parseEquality()
+// <bool>     -> <bool> || <join> | <join>
+// <join>     -> <join> && <equality> | <equality>
+// <equality> -> <equality> == <rel> | <equality> != <rel> | <rel>
+// <rel>      -> <expr> < <expr> | <expr> <= <expr> | ... | <expr>
+// <expr>     -> <expr> + <term> | <expr> - <term> | <term>
+// <term>     -> <term> * <unary> | <term> / <unary> | <unary>
+// Instead of one function per level, every binary operator is looked up in
+// binaryOperators: the right operand is parsed with a higher minimum
+// precedence, which makes the operator left associative.
+Expression* Parser::parseExpression(int minPrecedence)
 {
-    Expression* exp = parseRel();
-    while(tokenItr->tag == Token::EQ || tokenItr->tag == Token::NOT_EQ)
-    {
-        if(tokenItr->tag == Token::EQ)
-        {
-            safe_next();
-            exp = em.makeBinOp(Op::EQ, exp, parseRel());
-        }
-        else if(tokenItr->tag == Token::NOT_EQ)
-        {
-            safe_next();
-            exp = em.makeBinOp(Op::NOT_EQ, exp, parseRel());
-        }
-    }
-    return exp;
-}
+    Expression* exp = parseUnaryOp();
+    int expPrecedence = PRIMARY_PRECEDENCE;
 
-Expression* Parser::parseRel()
-{
-    switch((tokenItr+1)->tag)
+    for(;;)
     {
-        case Token::LESS:
-        {
-            Expression* exp1 = parseLowerPrecedenceBinOp();
-            safe_next();
-            Expression* exp2 = parseLowerPrecedenceBinOp();
-            return em.makeRel(exp1,exp2,Rel::LESS);
-        }
-
-        case Token::LESS_EQ:
-        {
-            Expression* exp1 = parseLowerPrecedenceBinOp();
-            safe_next();
-            Expression* exp2 = parseLowerPrecedenceBinOp();
-            return em.makeRel(exp1,exp2,Rel::LESS_EQ);
-        }
-        
-        case Token::MORE:
-        {
-            Expression* exp1 = parseLowerPrecedenceBinOp();
-            safe_next();
-            Expression* exp2 = parseLowerPrecedenceBinOp();
-            return em.makeRel(exp1,exp2,Rel::MORE);
-        }
-
-        case Token::MORE_EQ:
-        {
-            Expression* exp1 = parseLowerPrecedenceBinOp();
-            safe_next();
-            Expression* exp2 = parseLowerPrecedenceBinOp();
-            return em.makeRel(exp1,exp2,Rel::MORE_EQ);
-        } 
-
-        default:
-        {
-            return parseLowerPrecedenceBinOp();
-        }
-    }
-
-}
-
+        const BinaryOperator& op = binaryOperators[tokenItr->tag];
+        if(op.precedence < minPrecedence)
+            break;
+        // Rel is not associative: its left operand cannot be a Rel
+        // (or anything binding looser than a Rel) built at this level
+        if(op.kind == BinaryKind::REL && expPrecedence <= op.precedence)
+            break;
 
-Expression* Parser::parseLowerPrecedenceBinOp()
-{
-    Expression* exp = parseHigerPrecedenceBinOp();
-    while(tokenItr->tag == Token::ADD || tokenItr->tag == Token::MIN)
-    {
-        if(tokenItr->tag == Token::ADD)
-        {
-            safe_next();
-            exp = em.makeBinOp(Op::ADD, exp, parseHigerPrecedenceBinOp());
-        }
-        else if(tokenItr->tag == Token::MIN)
-        {
-            safe_next();
-            exp = em.makeBinOp(Op::SUB, exp, parseHigerPrecedenceBinOp());
-        }
-    }
-    return exp;   
-}
+        safe_next();
+        Expression* right = parseExpression(op.precedence + 1);
 
-Expression* Parser::parseHigerPrecedenceBinOp()
-{
-    Expression* exp = parseUnaryOp();
-    while(tokenItr->tag == Token::MUL || tokenItr->tag == Token::DIV)
-    {
-        if(tokenItr->tag == Token::MUL)
-        {
-            safe_next();
-            exp = em.makeBinOp(Op::MUL, exp, parseUnaryOp());
-        }
-        else if(tokenItr->tag == Token::DIV)
+        switch(op.kind)
         {
-            safe_next();
-            exp = em.makeBinOp(Op::DIV, exp, parseUnaryOp());
+            case BinaryKind::OR:
+                exp = em.makeOr(exp, right);
+                break;
+            case BinaryKind::AND:
+                exp = em.makeAnd(exp, right);
+                break;
+            case BinaryKind::REL:
+                exp = em.makeRel(exp, right, static_cast<Rel::OpCode>(op.code));
+                break;
+            default:
+                exp = em.makeBinOp(static_cast<Op::BinOpCode>(op.code), exp, right);
+                break;
         }
+        expPrecedence = op.precedence;
     }
-    return exp;   
+    return exp;
 }
 
 Expression* Parser::parseUnaryOp()
@@ -364,9 +505,9 @@ Expression* Parser::parseFactor()
 
         case Token::NUM:
         {
-            std::string word = tokenItr->word;
+            int value = tokenItr->value;
             safe_next();
-            return em.makeIntConstant(std::stoi(word));
+            return em.makeIntConstant(value);
         }
 
         //weather token is true or false boolConstant is created
@@ -374,20 +515,12 @@ Expression* Parser::parseFactor()
 
         case Token::FALSE:
         {
-            std::string word = tokenItr->word;
+            bool value = tokenItr->tag == Token::TRUE;
             safe_next();
-            if(word == Token::id2word[Token::TRUE])
-                return em.makeBoolConstant(true);
-            
-            else if(word == Token::id2word[Token::FALSE])
-                return em.makeBoolConstant(false);
+            return em.makeBoolConstant(value);
         }
 
         default:
-        {
-            std::stringstream ss("Error while parsing factor");
-            ss<<tokenItr->tag;
-            throw ParseError(ss.str());
-        }
+            throw ParseError("Error while parsing factor " + std::to_string(tokenItr->tag));
     }       
 }
\ No newline at end of file
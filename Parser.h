@@ -1,18 +1,40 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "Node.h"
 #include "ExpressionManager.h"
 #include "Token.h"
+#include "TokenStream.h"
+#include "StructureIndex.h"
 /*#include "Exceptions.h"
 #include "Expression.h"
 #include "Stmt.h"
 #include "Block.h"
 #include "Program.h"
 */
+// Modo di analisi dei blocchi annidati:
+// - STRICT: tutto il programma viene analizzato subito (e' anche il modo per
+//   validare un sorgente, perche' ogni errore viene segnalato dal parsing);
+// - LAZY: di un blocco annidato si registra solo l'intervallo di token, che
+//   viene analizzato al primo accesso a Block::getDecls()/getStmts(). Gli
+//   errori sintattici al suo interno emergono quindi durante la visita.
+enum class ParseMode { STRICT, LAZY };
+
+class LazyBlockLoader;
+class IncrementalParser;
+
+// Blocco dell'AST e intervallo dei suoi token (dalla '{' alla '}')
+struct BlockSpan {
+    Block* block;
+    std::uint32_t first;
+    std::uint32_t last;
+};
+
 // Function object per il parsing di espressioni
 // Funzione di parsing: restituisce "true" se l'espressione � corretta
 // "false" altrimenti. Suppone che nella stringa vi siano solo simboli
@@ -20,16 +42,33 @@
 class Parser {
 
 public:
-    Parser(ExpressionManager& manager, std::vector<Token>& tokenStream)
-     : em{ manager }, tokenItr {tokenStream.begin()}, streamEnd{tokenStream.end()}{}
+    // I token possono provenire da un TokenStream gia' completo oppure da
+    // una sorgente che li produce su richiesta (StreamLexer): la grammatica
+    // e' la stessa, cambia solo il modo in cui si riempie la finestra
+    Parser(ExpressionManager& manager, TokenSource& tokenSource)
+     : source{ tokenSource }, em{ manager }
+    {
+        TokenWindow window = source.fill(nullptr, lookahead);
+        tokenItr = window.first;
+        windowEnd = window.last;
+    }
+
+    // Con un TokenStream completo i blocchi annidati possono essere
+    // rimandati (ParseMode::LAZY) e, con numThreads > 1, gli statement del
+    // blocco piu' esterno vengono analizzati in parallelo. Se le parentesi
+    // graffe non sono bilanciate si analizza comunque tutto subito e in
+    // modo seriale, cosi' l'errore viene segnalato come nel modo STRICT.
+    Parser(ExpressionManager& manager, TokenStream& tokens, ParseMode mode,
+           unsigned numThreads = 1);
+
     ~Parser() = default;
     Parser(Parser const&) = delete;
     Parser& operator=(Parser const&) = delete;
 
     //un oggetto p di tipo Parser inizia il parsing chiamando p()
     Program* operator()() {
-        Program* p = parseProgram();
-        if (tokenItr != streamEnd) {
+        Program* p = threads > 1 ? parseProgramParallel() : parseProgram();
+        if (tokenItr->tag != Token::END_OF_INPUT) {
             throw ParseError("Unexpected end of input");
         }
         return p;
@@ -38,21 +77,84 @@ public:
 
 
 private:
-    std::vector<Token>::const_iterator streamEnd;
-
-    //Vector di token prodotto dal tokenizer
-    std::vector<Token>::const_iterator tokenItr;
+    friend class LazyBlockLoader;
+    friend class IncrementalParser;
+
+    // Parser posizionato sul token firstToken di tokens: usato per il corpo
+    // di un blocco rimandato e per le parti del programma analizzate in
+    // parallelo (loader e' nullptr nel modo STRICT)
+    Parser(ExpressionManager& manager, TokenStream& tokens,
+           LazyBlockLoader* loader, std::size_t firstToken);
+
+    // Token che devono essere sempre disponibili nella finestra a partire
+    // dal corrente: la grammatica e' LL(1)
+    static constexpr std::size_t lookahead = 1;
+
+    //Finestra di token fornita dalla sorgente, terminata da END_OF_INPUT
+    //quando l'input e' finito
+    const Token* tokenItr;
+    const Token* windowEnd;
+
+    //Sorgente dei token, da cui si leggono anche le parole di ID e NUM
+    TokenSource& source;
   
     // Riferimento all'expression manager "di sistema"
     ExpressionManager& em;
 
+    // Liste di lavoro in cui si accumulano gli elementi di Stmts e Decls
+    // prima di copiarli nell'array definitivo
+    std::vector<Stmt*> stmtScratch;
+    std::vector<Decl*> declScratch;
+
+    // Solo con un TokenStream completo: lo stream e il suo inizio, per
+    // convertire tokenItr in un indice e viceversa
+    TokenStream* tokenStream = nullptr;
+    const Token* tokensBegin = nullptr;
+
+    // Solo nel modo LAZY: loader dei blocchi rimandati
+    LazyBlockLoader* lazyLoader = nullptr;
+
+    // Indice strutturale (posseduto dal loader nel modo LAZY, da
+    // ownStructure altrimenti); nullptr se non serve o non e' valido
+    const StructureIndex* structure = nullptr;
+    StructureIndex ownStructure;
+
+    // Usati da IncrementalParser: se spanSink non e' nullptr vi si aggiunge,
+    // in ordine di posizione, l'intervallo di ogni blocco analizzato o
+    // riusato; [reuseItr, reuseEnd) sono blocchi dell'AST precedente (in
+    // ordine di posizione) che si riusano se un blocco inizia nella stessa
+    // posizione, perche' i loro token non sono cambiati
+    std::vector<BlockSpan>* spanSink = nullptr;
+    const BlockSpan* reuseItr = nullptr;
+    const BlockSpan* reuseEnd = nullptr;
+
+    // Thread per il parsing parallelo e numero minimo di token perche'
+    // convenga: sotto questa soglia si procede in modo seriale
+    unsigned threads = 1;
+    static constexpr std::size_t minParallelTokens = 1 << 16;
+    // parti in cui si divide il programma per ogni thread, per bilanciare
+    // il carico fra statement di dimensioni diverse
+    static constexpr std::size_t chunksPerThread = 4;
+
+    // Blocchi con meno token di cosi' vengono comunque analizzati subito:
+    // rimandarli costerebbe piu' che analizzarli
+    static constexpr std::uint32_t minLazyTokens = 32;
+
     // Parser a discesa ricorsiva nella struttura dell'espressione
     //Expression* recursiveParse(std::vector<Token>::const_iterator& tokenItr);
 
     
     Program* parseProgram();
+    Program* parseProgramParallel();
 
     Block* parseBlock();
+    // Nel modo LAZY: salta il blocco che inizia sul token corrente
+    Block* parseLazyBlock();
+    // Blocco dell'AST precedente che inizia sul token corrente (nullptr se
+    // non ce n'e' uno riusabile), dopo il quale si prosegue
+    Block* reuseBlock();
+    // Analizza il corpo di un blocco rimandato
+    void loadBlock(Block* block);
 
     //parsing relativo a dichiarazioni
     Decls* parseDecls();
@@ -61,28 +163,43 @@ private:
     Id* parseId();
     //parsing relativo a stmts
     Stmts* parseStmts();
+    // Analizza gli statement fino alla fine del blocco e costruisce Stmts
+    // con tutti quelli accumulati su stmtScratch a partire da mark
+    Stmts* finishStmts(std::size_t mark);
+    // Analizza gli statement che iniziano prima del token end e li aggiunge
+    // a out; restituisce true se l'ultimo termina esattamente prima di end
+    bool parseStmtRange(std::size_t end, std::vector<Stmt*>& out);
     Stmt* parseStmt();
 
     
 
-    Expression* parseExpression();
+    // Precedence climbing: parses an expression whose binary operators all
+    // have precedence >= minPrecedence (see binaryOperators in Parser.cpp)
+    Expression* parseExpression(int minPrecedence = 1);
 
-    Expression* parseOr();
-    Expression* parseAnd();
-    Expression* parseEquality();
-    Expression* parseRel();
-    Expression* parseLowerPrecedenceBinOp();
-    Expression* parseHigerPrecedenceBinOp();
     Expression* parseUnaryOp();
     Expression* parseFactor();
 
 
+    // Posizione del token corrente nel TokenStream
+    std::uint32_t tokenIndex() const {
+        return static_cast<std::uint32_t>(tokenItr - tokensBegin);
+    }
+
     // Avanzamento "sicuro" di un iteratore
     void safe_next() {
-        if (tokenItr == streamEnd) {
+        if (tokenItr->tag == Token::END_OF_INPUT) {
             throw ParseError("Unexpected end of input");
         }
         ++tokenItr;
+        // si chiede alla sorgente di riempire la finestra solo se mancano
+        // token di lookahead e l'input non e' gia' terminato
+        if (static_cast<std::size_t>(windowEnd - tokenItr) < lookahead
+            && windowEnd[-1].tag != Token::END_OF_INPUT) {
+            TokenWindow window = source.fill(tokenItr, lookahead);
+            tokenItr = window.first;
+            windowEnd = window.last;
+        }
     }
 
     void consumeToken(const int tokenId)
@@ -99,4 +216,22 @@ private:
 
 };
 
+// Materializza i blocchi rimandati da un Parser in modo LAZY. E' posseduto
+// dall'ExpressionManager, quindi vive quanto l'AST; il TokenStream deve
+// restare vivo finche' ci sono blocchi non ancora analizzati.
+class LazyBlockLoader : public BlockLoader {
+
+public:
+    LazyBlockLoader(ExpressionManager& manager, TokenStream& tokens, StructureIndex index)
+     : em{ manager }, stream{ tokens }, structure{ std::move(index) } { }
+
+    void load(Block* block) override;
+    const StructureIndex& getStructure() const { return structure; }
+
+private:
+    ExpressionManager& em;
+    TokenStream& stream;
+    StructureIndex structure;
+};
+
 #endif
@@ -0,0 +1,435 @@
+#include "ProgramImage.h"
+
+#include <cstring>
+#include <vector>
+
+#include "Visitor.h"
+
+namespace {
+
+	using namespace ProgramImage;
+
+	constexpr char magicBytes[8]{ 'C', 'M', 'P', 'I', 'M', 'A', 'G', 'E' };
+
+	std::uint64_t align8(std::uint64_t n) {
+		return (n + 7) & ~std::uint64_t{ 7 };
+	}
+
+	// Visita l'AST in ordine posticipato: ogni visita lascia in last
+	// l'indice del nodo creato
+	class Builder : public Visitor {
+
+	public:
+		std::vector<ImageNode> nodes;
+		std::vector<std::uint32_t> children;
+		std::string text;
+		std::uint32_t last = NONE;
+
+		void visitProgram(Program* program) override {
+			add(PROGRAM, 0, child(program->getBlock()));
+		}
+
+		void visitBlock(Block* block) override {
+			std::uint32_t decls = block->getDecls() ? child(block->getDecls()) : NONE;
+			std::uint32_t stmts = block->getStmts() ? child(block->getStmts()) : NONE;
+			add(BLOCK, 0, decls, stmts);
+		}
+
+		void visitDecls(Decls* decls) override {
+			list(DECLS, decls->begin(), decls->end());
+		}
+
+		void visitDecl(Decl* decl) override {
+			std::uint32_t type = child(decl->getType());
+			add(DECL, 0, type, child(decl->getId()));
+		}
+
+		void visitType(Type* type) override {
+			add(TYPE, type->getType());
+		}
+
+		void visitVectorType(vectorType* type) override {
+			add(VECTOR_TYPE, type->getType(), static_cast<std::uint32_t>(type->getSize()));
+		}
+
+		void visitId(Id* id) override {
+			std::string_view name = id->getName();
+			std::uint32_t offset = static_cast<std::uint32_t>(text.size());
+			text += name;
+			add(ID, 0, offset, static_cast<std::uint32_t>(name.size()));
+		}
+
+		void visitStmts(Stmts* stmts) override {
+			list(STMTS, stmts->begin(), stmts->end());
+		}
+
+		void visitIf(If* ifNode) override {
+			std::uint32_t condition = child(ifNode->getCondition());
+			add(IF, 0, condition, child(ifNode->getStmt()));
+		}
+
+		void visitElse(Else* elseNode) override {
+			std::uint32_t condition = child(elseNode->getCondition());
+			std::uint32_t ifTrue = child(elseNode->getifTrueStmt());
+			add(ELSE, 0, condition, ifTrue, child(elseNode->getifFalseStmt()));
+		}
+
+		void visitWhile(While* whileNode) override {
+			std::uint32_t condition = child(whileNode->getCondition());
+			add(WHILE, 0, condition, child(whileNode->getStmt()));
+		}
+
+		void visitDo(Do* doNode) override {
+			std::uint32_t condition = child(doNode->getCondition());
+			add(DO, 0, condition, child(doNode->getStmt()));
+		}
+
+		void visitSet(Set* setNode) override {
+			std::uint32_t id = child(setNode->getId());
+			add(SET, 0, id, child(setNode->getExp()));
+		}
+
+		void visitSetElem(SetElem* setElemNode) override {
+			std::uint32_t id = child(setElemNode->getId());
+			std::uint32_t index = child(setElemNode->getIndex());
+			add(SET_ELEM, 0, id, index, child(setElemNode->getExp()));
+		}
+
+		void visitBreak(Break*) override {
+			add(BREAK, 0);
+		}
+
+		void visitPrint(Print* printNode) override {
+			add(PRINT, 0, child(printNode->getExp()));
+		}
+
+		void visitIntConstant(intConstant* numNode) override {
+			add(INT_CONSTANT, 0, static_cast<std::uint32_t>(numNode->getValue()));
+		}
+
+		void visitBoolConstant(boolConstant* boolNode) override {
+			add(BOOL_CONSTANT, 0, boolNode->getValue());
+		}
+
+		void visitNot(Not* notNode) override {
+			add(NOT, 0, child(notNode->getExp()));
+		}
+
+		void visitAnd(And* andNode) override {
+			std::uint32_t left = child(andNode->getLeftExp());
+			add(AND, 0, left, child(andNode->getRightExp()));
+		}
+
+		void visitOr(Or* orNode) override {
+			std::uint32_t left = child(orNode->getLeftExp());
+			add(OR, 0, left, child(orNode->getRightExp()));
+		}
+
+		void visitRel(Rel* relNode) override {
+			std::uint32_t left = child(relNode->getLeftExp());
+			add(REL, relNode->getOp(), left, child(relNode->getRightExp()));
+		}
+
+		void visitBinOp(Arithm* arithmNode) override {
+			std::uint32_t left = child(arithmNode->getLeftExp());
+			add(ARITHM, arithmNode->getOp(), left, child(arithmNode->getRightExp()));
+		}
+
+		void visitUnaryOp(Unary* unaryNode) override {
+			add(UNARY, unaryNode->getOp(), child(unaryNode->getExp()));
+		}
+
+		void visitAccess(Access* accessNode) override {
+			std::uint32_t id = child(accessNode->getId());
+			add(ACCESS, 0, id, child(accessNode->getIndex()));
+		}
+
+	private:
+		std::uint32_t child(Node* node) {
+			node->accept(this);
+			return last;
+		}
+
+		void add(Kind kind, int code, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0) {
+			last = static_cast<std::uint32_t>(nodes.size());
+			nodes.push_back(ImageNode{ kind, static_cast<std::uint8_t>(code), 0, a, b, c });
+		}
+
+		// gli elementi vengono visitati prima di riservare il loro
+		// intervallo, perche' possono contenere a loro volta delle liste
+		template <typename T>
+		void list(Kind kind, T** begin, T** end) {
+			std::vector<std::uint32_t> items;
+			items.reserve(end - begin);
+			for (T** item = begin; item != end; ++item)
+				items.push_back(child(*item));
+			std::uint32_t start = static_cast<std::uint32_t>(children.size());
+			children.insert(children.end(), items.begin(), items.end());
+			add(kind, 0, start, static_cast<std::uint32_t>(items.size()));
+		}
+	};
+
+	// Stampa ricorsiva, nodo per nodo come in PrintVisitor
+	class Printer {
+
+	public:
+		Printer(const View& v, std::ostream& o) : image{ v }, out{ o } { }
+
+		void print(std::uint32_t index) {
+			const ImageNode& n = image.node(index);
+			switch (n.kind) {
+			case PROGRAM:
+				out << "Program(";
+				print(n.a);
+				out << ")";
+				break;
+			case BLOCK:
+				out << "Block(";
+				optional(n.a);
+				out << ", ";
+				optional(n.b);
+				out << ")";
+				break;
+			case DECLS:
+				list(n, "Decls(");
+				break;
+			case DECL:
+				out << "Decl(";
+				print(n.a);
+				out << ", ";
+				print(n.b);
+				out << ")";
+				break;
+			case TYPE:
+				out << "Type(" << Type::typeid2String[n.code] << ")";
+				break;
+			case VECTOR_TYPE:
+				out << "VectorType(" << Type::typeid2String[n.code]
+					<< ", [" << static_cast<int>(n.a) << "]" << ")";
+				break;
+			case ID:
+				out << "Id(" << image.name(n) << ")";
+				break;
+			case STMTS:
+				list(n, "Stmts(");
+				break;
+			case IF:
+				binary("If(", n.a, ", ", n.b);
+				break;
+			case ELSE:
+				out << "Else(";
+				print(n.a);
+				out << ", ";
+				print(n.b);
+				out << ", ";
+				print(n.c);
+				out << ")";
+				break;
+			case WHILE:
+				binary("While(", n.a, ", ", n.b);
+				break;
+			case DO:
+				binary("Do(", n.a, ", ", n.b);
+				break;
+			case SET:
+				binary("Set(", n.a, ", ", n.b);
+				break;
+			case SET_ELEM:
+				out << "SetElem(";
+				print(n.a);
+				out << ",[";
+				print(n.b);
+				out << "], ";
+				print(n.c);
+				out << ")";
+				break;
+			case BREAK:
+				out << "Break()";
+				break;
+			case PRINT:
+				out << "Print(";
+				print(n.a);
+				out << ")";
+				break;
+			case INT_CONSTANT:
+				out << "IntConstant(" << static_cast<int>(n.a) << ")";
+				break;
+			case BOOL_CONSTANT:
+				out << "BoolConstant(" << (n.a != 0) << ")";
+				break;
+			case NOT:
+				out << "Not(";
+				print(n.a);
+				out << ")";
+				break;
+			case AND:
+				binary("And(", n.a, ", ", n.b);
+				break;
+			case OR:
+				binary("Or(", n.a, ", ", n.b);
+				break;
+			case REL:
+				out << "Rel(" << Rel::opCode2String[n.code] << ", ";
+				binary("", n.a, ", ", n.b);
+				break;
+			case ARITHM:
+				out << "Arithm(" << Op::binOp2String[n.code] << ", ";
+				binary("", n.a, ", ", n.b);
+				break;
+			case UNARY:
+				out << "Unary(" << Op::unaryOp2String[n.code] << ", ";
+				print(n.a);
+				out << ")";
+				break;
+			case ACCESS:
+				out << "Access(";
+				print(n.a);
+				out << ",[";
+				print(n.b);
+				out << ",] )";
+				break;
+			}
+		}
+
+	private:
+		const View& image;
+		std::ostream& out;
+
+		void optional(std::uint32_t index) {
+			if (index == NONE)
+				out << "NULL";
+			else
+				print(index);
+		}
+
+		// open + a + separator + b + ")"
+		void binary(const char* open, std::uint32_t a, const char* separator, std::uint32_t b) {
+			out << open;
+			print(a);
+			out << separator;
+			print(b);
+			out << ")";
+		}
+
+		// forma annidata List(x1, List(x2, NULL))
+		void list(const ImageNode& n, const char* open) {
+			for (const std::uint32_t* item = image.childrenBegin(n); item != image.childrenEnd(n); ++item) {
+				out << open;
+				print(*item);
+				out << ", ";
+			}
+			out << "NULL";
+			for (std::uint32_t i = 0; i < n.b; ++i)
+				out << ")";
+		}
+	};
+
+}
+
+
+std::string ProgramImage::build(Program* program, const TokenStream& tokens,
+	std::uint64_t compilerHash, std::uint64_t sourceHash, const Bytecode* bytecode) {
+
+	Builder builder;
+	program->accept(&builder);
+
+	Header header{};
+	std::memcpy(header.magic, magicBytes, sizeof magicBytes);
+	header.format = formatVersion;
+	header.headerSize = sizeof(Header);
+	header.compilerHash = compilerHash;
+	header.sourceHash = sourceHash;
+	header.sourceSize = tokens.getSource().size();
+	header.tokenCount = static_cast<std::uint32_t>(tokens.size());
+	header.nodeCount = static_cast<std::uint32_t>(builder.nodes.size());
+	header.childCount = static_cast<std::uint32_t>(builder.children.size());
+	header.textSize = static_cast<std::uint32_t>(builder.text.size());
+	header.root = builder.last;
+	header.tokensOffset = align8(sizeof(Header));
+	header.nodesOffset = align8(header.tokensOffset + std::uint64_t{ header.tokenCount } * sizeof(Token));
+	header.childrenOffset = align8(header.nodesOffset + std::uint64_t{ header.nodeCount } * sizeof(ImageNode));
+	header.textOffset = align8(header.childrenOffset + std::uint64_t{ header.childCount } * sizeof(std::uint32_t));
+	if (bytecode) {
+		header.codeCount = static_cast<std::uint32_t>(bytecode->code.size());
+		header.variableCount = static_cast<std::uint32_t>(bytecode->variables.size());
+		header.messageCount = static_cast<std::uint32_t>(bytecode->messages.size());
+		header.bytecodeTextSize = static_cast<std::uint32_t>(bytecode->text.size());
+		header.frameSize = bytecode->frameSize;
+		header.stackSize = bytecode->stackSize;
+	}
+	header.codeOffset = align8(header.textOffset + header.textSize);
+	header.variablesOffset = align8(header.codeOffset + std::uint64_t{ header.codeCount } * sizeof(Instruction));
+	header.messagesOffset = align8(header.variablesOffset + std::uint64_t{ header.variableCount } * sizeof(Bytecode::Variable));
+	header.bytecodeTextOffset = align8(header.messagesOffset + std::uint64_t{ header.messageCount } * sizeof(Bytecode::Message));
+
+	std::string image(header.bytecodeTextOffset + header.bytecodeTextSize, '\0');
+	// le sezioni vuote possono venire da vettori senza memoria (data() nullo)
+	auto section = [&](std::uint64_t offset, const void* data, std::uint64_t bytes) {
+		if (bytes != 0)
+			std::memcpy(&image[offset], data, bytes);
+	};
+	section(0, &header, sizeof header);
+	section(header.tokensOffset, tokens.getTokens().data(), header.tokenCount * sizeof(Token));
+	section(header.nodesOffset, builder.nodes.data(), header.nodeCount * sizeof(ImageNode));
+	section(header.childrenOffset, builder.children.data(), header.childCount * sizeof(std::uint32_t));
+	section(header.textOffset, builder.text.data(), header.textSize);
+	if (bytecode) {
+		section(header.codeOffset, bytecode->code.data(), header.codeCount * sizeof(Instruction));
+		section(header.variablesOffset, bytecode->variables.data(), header.variableCount * sizeof(Bytecode::Variable));
+		section(header.messagesOffset, bytecode->messages.data(), header.messageCount * sizeof(Bytecode::Message));
+		section(header.bytecodeTextOffset, bytecode->text.data(), header.bytecodeTextSize);
+	}
+	return image;
+}
+
+
+bool ProgramImage::View::open(const char* data, std::size_t size,
+	std::uint64_t compilerHash, std::uint64_t sourceHash, std::uint64_t sourceSize) {
+
+	if (size < sizeof(Header) || reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+		return false;
+	const Header* h = reinterpret_cast<const Header*>(data);
+	if (std::memcmp(h->magic, magicBytes, sizeof magicBytes) != 0 || h->format != formatVersion
+		|| h->headerSize != sizeof(Header) || h->compilerHash != compilerHash
+		|| h->sourceHash != sourceHash || h->sourceSize != sourceSize)
+		return false;
+
+	auto fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+		return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+	};
+	if (!fits(h->tokensOffset, std::uint64_t{ h->tokenCount } * sizeof(Token))
+		|| !fits(h->nodesOffset, std::uint64_t{ h->nodeCount } * sizeof(ImageNode))
+		|| !fits(h->childrenOffset, std::uint64_t{ h->childCount } * sizeof(std::uint32_t))
+		|| !fits(h->textOffset, h->textSize)
+		|| !fits(h->codeOffset, std::uint64_t{ h->codeCount } * sizeof(Instruction))
+		|| !fits(h->variablesOffset, std::uint64_t{ h->variableCount } * sizeof(Bytecode::Variable))
+		|| !fits(h->messagesOffset, std::uint64_t{ h->messageCount } * sizeof(Bytecode::Message))
+		|| !fits(h->bytecodeTextOffset, h->bytecodeTextSize)
+		|| h->root >= h->nodeCount)
+		return false;
+
+	header = h;
+	base = data;
+	tokens = reinterpret_cast<const Token*>(data + h->tokensOffset);
+	nodes = reinterpret_cast<const ImageNode*>(data + h->nodesOffset);
+	children = reinterpret_cast<const std::uint32_t*>(data + h->childrenOffset);
+	text = data + h->textOffset;
+	return true;
+}
+
+
+BytecodeView ProgramImage::View::bytecode() const {
+	BytecodeView view;
+	view.code = reinterpret_cast<const Instruction*>(base + header->codeOffset);
+	view.variables = reinterpret_cast<const Bytecode::Variable*>(base + header->variablesOffset);
+	view.messages = reinterpret_cast<const Bytecode::Message*>(base + header->messagesOffset);
+	view.text = base + header->bytecodeTextOffset;
+	view.frameSize = header->frameSize;
+	view.stackSize = header->stackSize;
+	return view;
+}
+
+
+void ProgramImage::print(const View& image, std::ostream& out) {
+	Printer{ image, out }.print(image.root());
+}
@@ -0,0 +1,151 @@
+#ifndef PROGRAM_IMAGE_H
+#define PROGRAM_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "Bytecode.h"
+#include "Node.h"
+#include "Token.h"
+#include "TokenStream.h"
+
+// Immagine binaria di un programma gia' analizzato, pensata per essere
+// scritta su disco e poi mappata in memoria (vedi CompileCache) e usata
+// cosi' com'e', senza ricostruire i nodi. Non contiene puntatori: i nodi
+// sono record di dimensione fissa in un array e si riferiscono ai figli
+// con il loro indice, le liste (Decls, Stmts) sono intervalli di un array
+// di indici e i nomi degli identificatori stanno in un'unica area di testo.
+// Contiene anche i token (con lo stesso layout di Token), le cui parole si
+// leggono dal sorgente da cui l'immagine e' stata prodotta, e puo'
+// contenere il Bytecode del programma, che VirtualMachine esegue
+// direttamente dall'immagine.
+namespace ProgramImage {
+
+	// Cambia ogni volta che cambia il formato
+	constexpr std::uint32_t formatVersion = 2;
+
+	// figlio assente (Decls e Stmts vuoti)
+	constexpr std::uint32_t NONE = UINT32_MAX;
+
+	enum Kind : std::uint8_t {
+		PROGRAM,		// a: blocco
+		BLOCK,			// a: Decls, b: Stmts (NONE se vuoti)
+		DECLS,			// a: primo elemento nell'array dei figli, b: numero di elementi
+		DECL,			// a: tipo, b: identificatore
+		TYPE,			// code: Type::TypeCode
+		VECTOR_TYPE,	// code: Type::TypeCode, a: dimensione
+		ID,				// a: posizione del nome nel testo, b: lunghezza
+		STMTS,			// come DECLS
+		IF,				// a: condizione, b: statement
+		ELSE,			// a: condizione, b: ramo vero, c: ramo falso
+		WHILE,			// a: condizione, b: statement
+		DO,				// a: condizione, b: statement
+		SET,			// a: identificatore, b: espressione
+		SET_ELEM,		// a: identificatore, b: indice, c: espressione
+		BREAK,
+		PRINT,			// a: espressione
+		INT_CONSTANT,	// a: valore
+		BOOL_CONSTANT,	// a: valore
+		NOT,			// a: espressione
+		AND,			// a, b: operandi
+		OR,				// a, b: operandi
+		REL,			// code: Rel::OpCode, a, b: operandi
+		ARITHM,			// code: Op::BinOpCode, a, b: operandi
+		UNARY,			// code: Op::UnaryOpCode, a: operando
+		ACCESS			// a: identificatore, b: indice
+	};
+
+	struct ImageNode {
+		std::uint8_t kind;
+		std::uint8_t code;
+		std::uint16_t unused;
+		std::uint32_t a;
+		std::uint32_t b;
+		std::uint32_t c;
+	};
+	static_assert(sizeof(ImageNode) == 16, "i nodi dell'immagine devono avere dimensione fissa");
+
+	struct Header {
+		char magic[8];
+		std::uint32_t format;
+		std::uint32_t headerSize;
+		std::uint64_t compilerHash;		// versione del compilatore che l'ha prodotta
+		std::uint64_t sourceHash;		// hash del contenuto del sorgente
+		std::uint64_t sourceSize;
+		std::uint32_t tokenCount;		// senza END_OF_INPUT
+		std::uint32_t nodeCount;
+		std::uint32_t childCount;
+		std::uint32_t textSize;
+		std::uint32_t root;				// nodo PROGRAM
+		// Bytecode (codeCount e' 0 se l'immagine non lo contiene)
+		std::uint32_t codeCount;
+		std::uint32_t variableCount;
+		std::uint32_t messageCount;
+		std::uint32_t bytecodeTextSize;
+		std::uint32_t frameSize;
+		std::uint32_t stackSize;
+		std::uint32_t unused;
+		// posizioni delle sezioni dall'inizio dell'immagine (allineate a 8)
+		std::uint64_t tokensOffset;
+		std::uint64_t nodesOffset;
+		std::uint64_t childrenOffset;
+		std::uint64_t textOffset;
+		std::uint64_t codeOffset;
+		std::uint64_t variablesOffset;
+		std::uint64_t messagesOffset;
+		std::uint64_t bytecodeTextOffset;
+	};
+
+	// Costruisce l'immagine del programma program, ottenuto da tokens, e
+	// del suo bytecode se non e' nullptr
+	std::string build(Program* program, const TokenStream& tokens,
+		std::uint64_t compilerHash, std::uint64_t sourceHash, const Bytecode* bytecode = nullptr);
+
+	// Vista su un'immagine in memoria (che deve restare valida e allineata
+	// a 8 byte). open() controlla in tempo costante l'intestazione: formato,
+	// compilatore e sorgente attesi, e che le sezioni stiano nell'immagine;
+	// se restituisce false la vista non va usata. I nodi non vengono
+	// ricontrollati uno per uno: le immagini sono prodotte solo da build()
+	// e scritte su disco in modo atomico (vedi CompileCache).
+	class View {
+
+	public:
+		bool open(const char* data, std::size_t size,
+			std::uint64_t compilerHash, std::uint64_t sourceHash, std::uint64_t sourceSize);
+
+		const Token* tokensBegin() const { return tokens; }
+		const Token* tokensEnd() const { return tokens + header->tokenCount; }
+
+		const ImageNode& node(std::uint32_t i) const { return nodes[i]; }
+		std::uint32_t root() const { return header->root; }
+		std::uint32_t nodeCount() const { return header->nodeCount; }
+
+		// Elementi della lista (DECLS o STMTS) list
+		const std::uint32_t* childrenBegin(const ImageNode& list) const { return children + list.a; }
+		const std::uint32_t* childrenEnd(const ImageNode& list) const { return children + list.a + list.b; }
+
+		// Nome di un nodo ID
+		std::string_view name(const ImageNode& id) const { return std::string_view{ text + id.a, id.b }; }
+
+		bool hasBytecode() const { return header->codeCount != 0; }
+		BytecodeView bytecode() const;
+
+	private:
+		const Header* header = nullptr;
+		const Token* tokens = nullptr;
+		const ImageNode* nodes = nullptr;
+		const std::uint32_t* children = nullptr;
+		const char* text = nullptr;
+		// inizio dell'immagine
+		const char* base = nullptr;
+	};
+
+	// Stampa il programma dell'immagine nella stessa forma di PrintVisitor
+	void print(const View& image, std::ostream& out);
+
+}
+
+#endif
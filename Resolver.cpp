@@ -0,0 +1,205 @@
+#include "Resolver.h"
+
+#include <string>
+
+#include "Exceptions.h"
+
+namespace {
+
+	std::string nameOf(Id* id) {
+		return std::string{ id->getName() };
+	}
+
+}
+
+
+void Resolver::resolve(Program* program) {
+	nextSlot = 0;
+	frameSize = 0;
+	resolveBlock(program->getBlock());
+	program->setFrameSize(frameSize);
+}
+
+
+// Le celle del blocco vengono liberate alla sua fine, per i blocchi successivi
+void Resolver::resolveBlock(Block* block) {
+	const std::uint32_t mark = nextSlot;
+	symbols.enterScope();
+	if (block->getDecls())
+		for (Decl* decl : *block->getDecls())
+			declare(decl);
+	if (block->getStmts())
+		for (Stmt* stmt : *block->getStmts())
+			resolveStmt(stmt);
+	symbols.exitScope();
+	nextSlot = mark;
+}
+
+
+void Resolver::declare(Decl* decl) {
+	Id* id = decl->getId();
+	const ScopedSymbolTable::Symbol* visible = symbols.lookup(id->getAtom());
+	if (visible && visible->depth == symbols.depth())
+		throw EvaluationError{ "Variable " + nameOf(id) + " already declared in this block" };
+
+	std::uint32_t size = 1;
+	if (decl->getType()->getKind() == NodeKind::VECTOR_TYPE) {
+		const int declared = static_cast<vectorType*>(decl->getType())->getSize();
+		if (declared <= 0)
+			throw EvaluationError{ "Vector " + nameOf(id) + " must have a positive size" };
+		size = static_cast<std::uint32_t>(declared);
+	}
+
+	const std::uint32_t slot = nextSlot;
+	nextSlot += size;
+	if (nextSlot > frameSize)
+		frameSize = nextSlot;
+	symbols.declare(id->getAtom(), ScopedSymbolTable::Symbol{ decl, slot, symbols.depth() });
+	decl->setId(bind(id, decl, slot));
+}
+
+
+Id* Resolver::use(Id* id) {
+	const ScopedSymbolTable::Symbol* symbol = symbols.lookup(id->getAtom());
+	if (!symbol)
+		throw EvaluationError{ "Undeclared variable " + nameOf(id) };
+	return bind(id, symbol->decl, symbol->slot);
+}
+
+
+Id* Resolver::bind(Id* id, Decl* decl, std::uint32_t slot) {
+	if (!id->getDecl() || id->getDecl() == decl) {
+		id->resolve(decl, slot);
+		return id;
+	}
+	Id*& other = renamed[decl];
+	if (!other) {
+		other = manager.makeUniqueId(id->getAtom());
+		other->resolve(decl, slot);
+	}
+	return other;
+}
+
+
+void Resolver::resolveStmt(Stmt* stmt) {
+	switch (stmt->getKind()) {
+	case NodeKind::BLOCK:
+		resolveBlock(static_cast<Block*>(stmt));
+		break;
+	case NodeKind::SET:
+	{
+		Set* setNode = static_cast<Set*>(stmt);
+		setNode->setId(use(setNode->getId()));
+		setNode->setExp(visit(setNode->getExp()));
+		break;
+	}
+	case NodeKind::SET_ELEM:
+	{
+		SetElem* setElemNode = static_cast<SetElem*>(stmt);
+		setElemNode->setId(use(setElemNode->getId()));
+		setElemNode->setIndex(visit(setElemNode->getIndex()));
+		setElemNode->setExp(visit(setElemNode->getExp()));
+		break;
+	}
+	case NodeKind::IF:
+	{
+		If* ifNode = static_cast<If*>(stmt);
+		ifNode->setCondition(visit(ifNode->getCondition()));
+		resolveStmt(ifNode->getStmt());
+		break;
+	}
+	case NodeKind::ELSE:
+	{
+		Else* elseNode = static_cast<Else*>(stmt);
+		elseNode->setCondition(visit(elseNode->getCondition()));
+		resolveStmt(elseNode->getifTrueStmt());
+		resolveStmt(elseNode->getifFalseStmt());
+		break;
+	}
+	case NodeKind::WHILE:
+	{
+		While* whileNode = static_cast<While*>(stmt);
+		whileNode->setCondition(visit(whileNode->getCondition()));
+		resolveStmt(whileNode->getStmt());
+		break;
+	}
+	case NodeKind::DO:
+	{
+		// il corpo viene prima della condizione anche nel sorgente
+		Do* doNode = static_cast<Do*>(stmt);
+		resolveStmt(doNode->getStmt());
+		doNode->setCondition(visit(doNode->getCondition()));
+		break;
+	}
+	case NodeKind::PRINT:
+	{
+		Print* printNode = static_cast<Print*>(stmt);
+		printNode->setExp(visit(printNode->getExp()));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+
+// Le espressioni vengono ricreate solo se un operando e' cambiato
+Expression* Resolver::visitBinOp(Arithm* arithmNode) {
+	Expression* left = visit(arithmNode->getLeftExp());
+	Expression* right = visit(arithmNode->getRightExp());
+	if (left == arithmNode->getLeftExp() && right == arithmNode->getRightExp())
+		return arithmNode;
+	return manager.makeBinOp(arithmNode->getOp(), left, right);
+}
+
+
+Expression* Resolver::visitUnaryOp(Unary* unaryNode) {
+	Expression* exp = visit(unaryNode->getExp());
+	if (exp == unaryNode->getExp())
+		return unaryNode;
+	return manager.makeUnaryOp(unaryNode->getOp(), exp);
+}
+
+
+Expression* Resolver::visitAccess(Access* accessNode) {
+	Id* vector = use(accessNode->getId());
+	Expression* index = visit(accessNode->getIndex());
+	if (vector == accessNode->getId() && index == accessNode->getIndex())
+		return accessNode;
+	return manager.makeAccess(vector, index);
+}
+
+
+Expression* Resolver::visitNot(Not* notNode) {
+	Expression* exp = visit(notNode->getExp());
+	if (exp == notNode->getExp())
+		return notNode;
+	return manager.makeNot(exp);
+}
+
+
+Expression* Resolver::visitAnd(And* andNode) {
+	Expression* left = visit(andNode->getLeftExp());
+	Expression* right = visit(andNode->getRightExp());
+	if (left == andNode->getLeftExp() && right == andNode->getRightExp())
+		return andNode;
+	return manager.makeAnd(left, right);
+}
+
+
+Expression* Resolver::visitOr(Or* orNode) {
+	Expression* left = visit(orNode->getLeftExp());
+	Expression* right = visit(orNode->getRightExp());
+	if (left == orNode->getLeftExp() && right == orNode->getRightExp())
+		return orNode;
+	return manager.makeOr(left, right);
+}
+
+
+Expression* Resolver::visitRel(Rel* relNode) {
+	Expression* left = visit(relNode->getLeftExp());
+	Expression* right = visit(relNode->getRightExp());
+	if (left == relNode->getLeftExp() && right == relNode->getRightExp())
+		return relNode;
+	return manager.makeRel(left, right, relNode->getOp());
+}
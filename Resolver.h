@@ -0,0 +1,67 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "ExpressionManager.h"
+#include "Node.h"
+#include "SymbolTable.h"
+#include "Visitor.h"
+
+// Risoluzione dei nomi: collega ogni Id alla sua Decl e gli assegna la
+// posizione della variabile nel frame del programma (Id::resolve), cosi'
+// che l'esecuzione acceda alle variabili per indice. Le variabili di un
+// blocco occupano le celle successive a quelle dei blocchi che lo
+// contengono e i blocchi fratelli riusano le stesse celle; la dimensione
+// del frame viene assegnata al Program. Un nome non dichiarato o dichiarato
+// due volte nello stesso blocco e' un EvaluationError.
+//
+// Con --share lo stesso Id (e le espressioni che lo contengono) puo'
+// comparire dove il nome indica variabili diverse: l'uso che non
+// corrisponde alla risoluzione gia' assegnata riceve un Id nuovo, non
+// condiviso, e le espressioni che lo contengono vengono ricreate con
+// l'ExpressionManager (come in ConstantFolder, senza modificare i nodi
+// condivisi).
+class Resolver final : public ResultVisitor<Expression*> {
+
+public:
+	explicit Resolver(ExpressionManager& em) : manager{ em } {}
+	Resolver(Resolver const&) = delete;
+	Resolver& operator=(Resolver const&) = delete;
+
+	// Risolve tutti i nomi del programma (con --lazy i blocchi vengono
+	// analizzati subito)
+	void resolve(Program* program);
+
+	Expression* visitId(Id* idNode) override { return use(idNode); }
+	Expression* visitIntConstant(intConstant* numNode) override { return numNode; }
+	Expression* visitBoolConstant(boolConstant* boolNode) override { return boolNode; }
+	Expression* visitBinOp(Arithm* arithmNode) override;
+	Expression* visitUnaryOp(Unary* unaryNode) override;
+	Expression* visitAccess(Access* accessNode) override;
+	Expression* visitNot(Not* notNode) override;
+	Expression* visitAnd(And* andNode) override;
+	Expression* visitOr(Or* orNode) override;
+	Expression* visitRel(Rel* relNode) override;
+
+private:
+	void resolveStmt(Stmt* stmt);
+	void resolveBlock(Block* block);
+	void declare(Decl* decl);
+
+	// Id che indica la variabile visibile con il nome di id
+	Id* use(Id* id);
+	// id stesso se non e' risolto o lo e' gia' a decl, altrimenti un Id
+	// nuovo risolto a decl
+	Id* bind(Id* id, Decl* decl, std::uint32_t slot);
+
+	ExpressionManager& manager;
+	ScopedSymbolTable symbols;
+	std::uint32_t nextSlot = 0;
+	std::uint32_t frameSize = 0;
+	// Id nuovi gia' creati, per dichiarazione
+	std::unordered_map<Decl*, Id*> renamed;
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "ScanKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SCAN_KERNELS_X86 1
+#if defined(__GNUC__)
+// le funzioni AVX2 vengono compilate con l'attributo target, cosi' il resto
+// del programma non richiede -mavx2 e la scelta avviene a runtime
+#define SCAN_KERNELS_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+	// Classi di caratteri nel locale "C"
+	inline bool isWhitespace(unsigned char c) {
+		return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+	}
+
+	inline bool isDigit(unsigned char c) {
+		return static_cast<unsigned char>(c - '0') <= 9;
+	}
+
+	inline bool isAlnum(unsigned char c) {
+		return isDigit(c) || static_cast<unsigned char>((c | 0x20) - 'a') <= 'z' - 'a';
+	}
+
+	template <bool (*Accept)(unsigned char)>
+	const char* scalarRun(const char* p, const char* end) {
+		while (p < end && Accept(static_cast<unsigned char>(*p)))
+			++p;
+		return p;
+	}
+
+#ifdef SCAN_KERNELS_X86
+
+	// x <= limit su byte senza segno
+	inline __m128i lessEqual(__m128i x, char limit) {
+		return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(limit)), x);
+	}
+
+	inline __m128i whitespaceMask(__m128i v) {
+		__m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+		__m128i control = lessEqual(_mm_sub_epi8(v, _mm_set1_epi8('\t')), '\r' - '\t');
+		return _mm_or_si128(space, control);
+	}
+
+	inline __m128i digitMask(__m128i v) {
+		return lessEqual(_mm_sub_epi8(v, _mm_set1_epi8('0')), 9);
+	}
+
+	inline __m128i alnumMask(__m128i v) {
+		__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+		__m128i alpha = lessEqual(_mm_sub_epi8(lower, _mm_set1_epi8('a')), 'z' - 'a');
+		return _mm_or_si128(alpha, digitMask(v));
+	}
+
+	// Avanza di 16 byte alla volta finche' tutti appartengono alla classe,
+	// poi individua il primo che non vi appartiene; la coda (< 16 byte)
+	// viene trattata in modo scalare
+	template <__m128i (*Mask)(__m128i), bool (*Accept)(unsigned char)>
+	const char* sse2Run(const char* p, const char* end) {
+		while (end - p >= 16) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			unsigned outside = ~static_cast<unsigned>(_mm_movemask_epi8(Mask(v))) & 0xFFFFu;
+			if (outside != 0)
+				return p + __builtin_ctz(outside);
+			p += 16;
+		}
+		return scalarRun<Accept>(p, end);
+	}
+
+#endif
+
+#ifdef SCAN_KERNELS_AVX2
+
+	AVX2_TARGET inline __m256i lessEqual256(__m256i x, char limit) {
+		return _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(limit)), x);
+	}
+
+	AVX2_TARGET inline __m256i whitespaceMask256(__m256i v) {
+		__m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+		__m256i control = lessEqual256(_mm256_sub_epi8(v, _mm256_set1_epi8('\t')), '\r' - '\t');
+		return _mm256_or_si256(space, control);
+	}
+
+	AVX2_TARGET inline __m256i digitMask256(__m256i v) {
+		return lessEqual256(_mm256_sub_epi8(v, _mm256_set1_epi8('0')), 9);
+	}
+
+	AVX2_TARGET inline __m256i alnumMask256(__m256i v) {
+		__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+		__m256i alpha = lessEqual256(_mm256_sub_epi8(lower, _mm256_set1_epi8('a')), 'z' - 'a');
+		return _mm256_or_si256(alpha, digitMask256(v));
+	}
+
+	// Come sse2Run ma con blocchi di 32 byte; la coda passa a SSE2
+	template <__m256i (*Mask)(__m256i), __m128i (*Mask128)(__m128i), bool (*Accept)(unsigned char)>
+	AVX2_TARGET const char* avx2Run(const char* p, const char* end) {
+		while (end - p >= 32) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			unsigned outside = ~static_cast<unsigned>(_mm256_movemask_epi8(Mask(v)));
+			if (outside != 0)
+				return p + __builtin_ctz(outside);
+			p += 32;
+		}
+		return sse2Run<Mask128, Accept>(p, end);
+	}
+
+#endif
+
+	const ScanKernels::Table scalarTable{
+		scalarRun<isWhitespace>, scalarRun<isAlnum>, scalarRun<isDigit>
+	};
+
+#ifdef SCAN_KERNELS_X86
+	const ScanKernels::Table sse2Table{
+		sse2Run<whitespaceMask, isWhitespace>,
+		sse2Run<alnumMask, isAlnum>,
+		sse2Run<digitMask, isDigit>
+	};
+#endif
+
+#ifdef SCAN_KERNELS_AVX2
+	const ScanKernels::Table avx2Table{
+		avx2Run<whitespaceMask256, whitespaceMask, isWhitespace>,
+		avx2Run<alnumMask256, alnumMask, isAlnum>,
+		avx2Run<digitMask256, digitMask, isDigit>
+	};
+#endif
+
+	ScanKernels::Isa current = ScanKernels::Isa::SCALAR;
+
+	// Miglior insieme di istruzioni disponibile sulla CPU
+	ScanKernels::Isa best() {
+#ifdef SCAN_KERNELS_AVX2
+		if (ScanKernels::supported(ScanKernels::Isa::AVX2))
+			return ScanKernels::Isa::AVX2;
+#endif
+#ifdef SCAN_KERNELS_X86
+		return ScanKernels::Isa::SSE2;
+#else
+		return ScanKernels::Isa::SCALAR;
+#endif
+	}
+
+	ScanKernels::Table select(ScanKernels::Isa isa) {
+		current = isa;
+		switch (isa) {
+#ifdef SCAN_KERNELS_AVX2
+		case ScanKernels::Isa::AVX2: return avx2Table;
+#endif
+#ifdef SCAN_KERNELS_X86
+		case ScanKernels::Isa::SSE2: return sse2Table;
+#endif
+		default:
+			current = ScanKernels::Isa::SCALAR;
+			return scalarTable;
+		}
+	}
+
+}
+
+ScanKernels::Table ScanKernels::active = select(best());
+
+ScanKernels::Isa ScanKernels::activeIsa() {
+	return current;
+}
+
+bool ScanKernels::supported(Isa isa) {
+	switch (isa) {
+	case Isa::SCALAR:
+		return true;
+#ifdef SCAN_KERNELS_X86
+	case Isa::SSE2:
+		return true;
+#endif
+#ifdef SCAN_KERNELS_AVX2
+	case Isa::AVX2:
+		// puo' essere chiamata durante l'inizializzazione statica
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+bool ScanKernels::use(Isa isa) {
+	if (!supported(isa))
+		return false;
+	active = select(isa);
+	return true;
+}
+
+const char* ScanKernels::isaName(Isa isa) {
+	switch (isa) {
+	case Isa::SSE2: return "SSE2";
+	case Isa::AVX2: return "AVX2";
+	default: return "scalare";
+	}
+}
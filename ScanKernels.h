@@ -0,0 +1,58 @@
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+// Kernel di scansione usati dal Tokenizer per trovare la fine di una
+// sequenza di spazi bianchi, di caratteri alfanumerici (identificatori)
+// o di cifre (costanti intere). Sulle CPU x86-64 esistono versioni SSE2
+// (16 byte per passo) e AVX2 (32 byte per passo), oltre a quella scalare;
+// la versione usata viene scelta all'avvio in base alla CPU.
+// Le classi di caratteri sono quelle di isspace/isalnum/isdigit nel locale "C".
+namespace ScanKernels {
+
+	enum class Isa { SCALAR, SSE2, AVX2 };
+
+	using Kernel = const char* (*)(const char* p, const char* end);
+
+	struct Table {
+		Kernel whitespace;
+		Kernel alnum;
+		Kernel digits;
+	};
+
+	// Kernel attualmente in uso
+	extern Table active;
+
+	// Insieme di istruzioni dei kernel in uso
+	Isa activeIsa();
+
+	// true se la CPU supporta isa
+	bool supported(Isa isa);
+
+	// Forza l'uso dei kernel di un certo insieme di istruzioni (se supportato);
+	// utile per i benchmark. Restituisce false se isa non e' disponibile.
+	bool use(Isa isa);
+
+	const char* isaName(Isa isa);
+
+	// Primo carattere non bianco in [p, end) (end se non esiste).
+	// Fra un token e l'altro c'e' spesso un solo carattere o nessuno:
+	// questi casi vengono risolti senza chiamare il kernel.
+	inline const char* skipWhitespace(const char* p, const char* end) {
+		if (p < end && *p != ' ' && static_cast<unsigned char>(*p - '\t') > '\r' - '\t')
+			return p;
+		return active.whitespace(p, end);
+	}
+
+	// Primo carattere non alfanumerico in [p, end)
+	inline const char* skipAlnum(const char* p, const char* end) {
+		return active.alnum(p, end);
+	}
+
+	// Primo carattere che non e' una cifra in [p, end)
+	inline const char* skipDigits(const char* p, const char* end) {
+		return active.digits(p, end);
+	}
+
+}
+
+#endif
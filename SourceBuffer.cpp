@@ -0,0 +1,111 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_BUFFER_HAS_MMAP 1
+#endif
+
+#include "SourceBuffer.h"
+
+SourceBuffer::SourceBuffer(const std::string& path)
+{
+#ifdef SOURCE_BUFFER_HAS_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Cannot open " + path);
+
+	struct stat info;
+	if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+		length = static_cast<std::size_t>(info.st_size);
+		// un file vuoto non si puo' mappare: resta un intervallo vuoto
+		if (length == 0) {
+			::close(fd);
+			bytes = fallback.data();
+			return;
+		}
+		void* addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED) {
+			// la scansione e' strettamente sequenziale
+			::madvise(addr, length, MADV_SEQUENTIAL);
+			::close(fd);
+			bytes = static_cast<const char*>(addr);
+			mapped = true;
+			return;
+		}
+	}
+	::close(fd);
+#endif
+
+	// Lettura in un colpo solo dell'intero file
+	std::ifstream inputFile(path, std::ios::in | std::ios::binary);
+	if (!inputFile)
+		throw std::runtime_error("Cannot open " + path);
+	std::ostringstream content;
+	content << inputFile.rdbuf();
+	fallback = content.str();
+	bytes = fallback.data();
+	length = fallback.size();
+}
+
+SourceBuffer SourceBuffer::fromMemory(std::string content)
+{
+	SourceBuffer buffer;
+	buffer.fallback = std::move(content);
+	buffer.bytes = buffer.fallback.data();
+	buffer.length = buffer.fallback.size();
+	return buffer;
+}
+
+SourceBuffer SourceBuffer::borrow(const char* data, std::size_t size)
+{
+	SourceBuffer buffer;
+	buffer.bytes = data;
+	buffer.length = size;
+	buffer.borrowed = true;
+	return buffer;
+}
+
+SourceBuffer::~SourceBuffer()
+{
+	release();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		mapped = other.mapped;
+		borrowed = other.borrowed;
+		length = other.length;
+		fallback = std::move(other.fallback);
+		bytes = (mapped || borrowed) ? other.bytes : fallback.data();
+		other.bytes = nullptr;
+		other.length = 0;
+		other.mapped = false;
+		other.borrowed = false;
+	}
+	return *this;
+}
+
+void SourceBuffer::release()
+{
+#ifdef SOURCE_BUFFER_HAS_MMAP
+	if (mapped)
+		::munmap(const_cast<char*>(bytes), length);
+#endif
+	bytes = nullptr;
+	length = 0;
+	mapped = false;
+	borrowed = false;
+}
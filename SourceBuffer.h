@@ -0,0 +1,54 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <string>
+
+// Contenuto di un file sorgente visto come un unico intervallo contiguo di byte.
+// Sui sistemi POSIX il file viene mappato in memoria con mmap, altrimenti
+// (o se la mappatura fallisce) viene letto con un'unica operazione di lettura.
+class SourceBuffer {
+
+public:
+	explicit SourceBuffer(const std::string& path);
+
+	// Buffer che prende possesso di un contenuto gia' letto in memoria
+	static SourceBuffer fromMemory(std::string content);
+
+	// Buffer che si limita a riferire memoria posseduta dal chiamante,
+	// che deve sopravvivere al SourceBuffer
+	static SourceBuffer borrow(const char* data, std::size_t size);
+
+	~SourceBuffer();
+	SourceBuffer(SourceBuffer const&) = delete;
+	SourceBuffer& operator=(SourceBuffer const&) = delete;
+	SourceBuffer(SourceBuffer&& other) noexcept;
+	SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+	const char* data() const { return bytes; }
+	std::size_t size() const { return length; }
+
+	const char* begin() const { return bytes; }
+	const char* end() const { return bytes + length; }
+
+	// true se il contenuto proviene da una mappatura del file
+	bool isMapped() const { return mapped; }
+
+private:
+	SourceBuffer() = default;
+
+	void release();
+
+	const char* bytes = nullptr;
+	std::size_t length = 0;
+	bool mapped = false;
+
+	// Copia del file usata quando mmap non e' disponibile
+	// (o contenuto passato a fromMemory)
+	std::string fallback;
+
+	// true se bytes punta a memoria del chiamante (borrow)
+	bool borrowed = false;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "StreamLexer.h"
+#include "Atoms.h"
+#include "Exceptions.h"
+#include "Tokenizer.h"
+
+TokenWindow StreamLexer::fill(const Token* from, std::size_t lookahead)
+{
+	// scarto i token gia' consumati dal Parser
+	if (from) {
+		tokens.erase(tokens.begin(), tokens.begin() + (from - tokens.data()));
+	}
+
+	// e il testo che non e' piu' riferito da alcun token
+	discardText();
+
+	while (!finished && tokens.size() < lookahead + batchSize)
+		lexOne();
+
+	return TokenWindow{ tokens.data(), tokens.data() + tokens.size() };
+}
+
+// Gli offset dei token sono relativi all'inizio di text. Si scarta il testo
+// che precede il primo token della finestra e quello (spazi gia'
+// attraversati) fra la fine dell'ultimo token e la posizione di scansione:
+// i token che seguono un tratto scartato vanno spostati indietro
+void StreamLexer::discardText()
+{
+	std::size_t keepFrom = tokens.empty() ? scanPos : tokens.front().offset;
+	std::size_t drop = std::min(keepFrom, scanPos);
+	if (drop > 0) {
+		text.erase(0, drop);
+		discarded += drop;
+		scanPos -= drop;
+		for (Token& t : tokens)
+			t.offset -= static_cast<std::uint32_t>(drop);
+	}
+
+	if (!tokens.empty()) {
+		std::size_t gapFrom = tokens.back().offset + tokens.back().length;
+		if (gapFrom < scanPos) {
+			text.erase(gapFrom, scanPos - gapFrom);
+			discarded += scanPos - gapFrom;
+			scanPos = gapFrom;
+		}
+	}
+}
+
+bool StreamLexer::readMore()
+{
+	if (inputEnded)
+		return false;
+	// gli spazi gia' attraversati non servono piu'
+	discardText();
+	if (text.size() + chunkSize > UINT32_MAX)
+		throw LexicalError("Token troppo lungo per il lessing a stream (dal byte "
+			+ std::to_string(discarded + scanPos) + ")");
+	std::size_t oldSize = text.size();
+	text.resize(oldSize + chunkSize);
+	input.read(&text[oldSize], chunkSize);
+	std::size_t got = static_cast<std::size_t>(input.gcount());
+	text.resize(oldSize + got);
+	if (got == 0 || !input)
+		inputEnded = true;
+	return got > 0;
+}
+
+void StreamLexer::lexOne()
+{
+	for (;;) {
+		const char* begin = text.data();
+		const char* end = begin + text.size();
+		const char* p = Tokenizer::skipWhitespace(begin + scanPos, end);
+		scanPos = p - begin;
+
+		// servono almeno due caratteri per gli operatori doppi (<=, ||, ...)
+		if (end - p < 2 && !inputEnded) {
+			readMore();
+			continue;
+		}
+		if (p == end) {
+			tokens.push_back(Token{ Token::END_OF_INPUT,
+				static_cast<std::uint32_t>(scanPos), 0 });
+			finished = true;
+			return;
+		}
+
+		Token token{ Token::END_OF_INPUT, 0, 0 };
+		const char* after = Tokenizer::scanToken(p, end, begin, token);
+
+		// un identificatore o un numero che arriva a fine blocco
+		// potrebbe proseguire nel blocco successivo
+		if (after == end && !inputEnded) {
+			readMore();
+			continue;
+		}
+
+		if (token.tag == Token::ID)
+			token.value = static_cast<std::int32_t>(AtomTable::global().intern(std::string_view(p, after - p)));
+		tokens.push_back(token);
+		scanPos = after - begin;
+		return;
+	}
+}
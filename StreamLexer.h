@@ -0,0 +1,63 @@
+#ifndef STREAM_LEXER_H
+#define STREAM_LEXER_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "Token.h"
+#include "TokenStream.h"
+
+// Lexer "a richiesta": legge l'input a blocchi e produce i token solo quando
+// il Parser li chiede con fill(). In memoria restano soltanto la finestra dei
+// token non ancora consumati e il testo a cui essi fanno riferimento, quindi
+// l'occupazione non dipende dalla dimensione del sorgente e l'input puo'
+// essere anche std::cin o una pipe. Gli offset dei token sono relativi al
+// testo conservato, non alla posizione nell'input, cosi' che l'input possa
+// superare i 4 GiB (solo un singolo token non puo').
+class StreamLexer : public TokenSource {
+
+public:
+	explicit StreamLexer(std::istream& in) : input{ in } { }
+	~StreamLexer() = default;
+	StreamLexer(StreamLexer const&) = delete;
+	StreamLexer& operator=(StreamLexer const&) = delete;
+
+	std::string_view spelling(const Token& t) const override {
+		return std::string_view{ text.data() + t.offset, t.length };
+	}
+
+	TokenWindow fill(const Token* from, std::size_t lookahead) override;
+
+private:
+	// byte letti dall'input ad ogni accesso
+	static constexpr std::size_t chunkSize = 64 * 1024;
+	// token prodotti ad ogni richiamo di fill, oltre al lookahead richiesto
+	static constexpr std::size_t batchSize = 256;
+
+	// scarta il testo che non e' piu' riferito dai token della finestra
+	void discardText();
+
+	// legge il blocco successivo, restituisce false a fine input
+	bool readMore();
+
+	// produce il token successivo (o END_OF_INPUT) in coda alla finestra
+	void lexOne();
+
+	std::istream& input;
+
+	// testo non ancora scartato e numero di byte dell'input gia' scartati
+	// (text[scanPos] e' il byte discarded + scanPos dell'input)
+	std::string text;
+	std::size_t discarded = 0;
+	// posizione di scansione all'interno di text
+	std::size_t scanPos = 0;
+	bool inputEnded = false;
+
+	// finestra dei token non ancora consumati
+	std::vector<Token> tokens;
+	bool finished = false;
+};
+
+#endif
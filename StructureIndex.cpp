@@ -0,0 +1,61 @@
+#include "StructureIndex.h"
+
+namespace {
+
+	bool startsStatement(int tag) {
+		switch (tag) {
+		case Token::ID:
+		case Token::IF:
+		case Token::DO:
+		case Token::WHILE:
+		case Token::BREAK:
+		case Token::PRINT:
+		case Token::LEFT_CURLY:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+}
+
+StructureIndex::StructureIndex(const TokenStream& stream)
+	: matching(stream.size(), NO_MATCH)
+{
+	const std::vector<Token>& tokens = stream.getTokens();
+	std::vector<std::uint32_t> open;
+	// il token precedente chiude uno statement del blocco piu' esterno
+	bool boundary = false;
+	// do del blocco piu' esterno di cui manca ancora il while finale
+	std::size_t pendingDo = 0;
+
+	for (std::size_t i = 0; i < stream.size(); ++i) {
+		int tag = tokens[i].tag;
+		if (boundary) {
+			// dopo la fine di uno statement un while chiude il do aperto
+			// piu' interno, se ce n'e' uno; altrimenti inizia un ciclo
+			if (tag == Token::WHILE && pendingDo > 0)
+				--pendingDo;
+			else if (startsStatement(tag))
+				statementStarts.push_back(static_cast<std::uint32_t>(i));
+		}
+		boundary = false;
+		if (tag == Token::DO && open.size() == 1)
+			++pendingDo;
+
+		if (tag == Token::LEFT_CURLY) {
+			open.push_back(static_cast<std::uint32_t>(i));
+		}
+		else if (tag == Token::RIGHT_CURLY) {
+			if (open.empty())
+				return;
+			matching[open.back()] = static_cast<std::uint32_t>(i);
+			open.pop_back();
+			boundary = open.size() == 1;
+		}
+		else if (tag == Token::END_STMT) {
+			boundary = open.size() == 1;
+		}
+	}
+	valid = open.empty();
+}
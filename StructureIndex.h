@@ -0,0 +1,45 @@
+#ifndef STRUCTURE_INDEX_H
+#define STRUCTURE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "TokenStream.h"
+
+// Indice della struttura a blocchi di uno stream di token, costruito con una
+// sola scansione lineare dei tag:
+// - per ogni '{' la posizione della '}' corrispondente, che permette al
+//   Parser di saltare un blocco intero in O(1);
+// - i token che iniziano uno statement del blocco piu' esterno, in cui il
+//   Parser puo' dividere il programma per analizzarlo in parallelo.
+class StructureIndex {
+
+public:
+	// valore di closing() per i token che non sono '{'
+	static constexpr std::uint32_t NO_MATCH = UINT32_MAX;
+
+	StructureIndex() = default;
+	explicit StructureIndex(const TokenStream& stream);
+
+	// false se le parentesi graffe non sono bilanciate: in quel caso
+	// l'indice non e' utilizzabile e il Parser deve procedere normalmente
+	bool isValid() const { return valid; }
+
+	// Indice della '}' che chiude la '{' in posizione open
+	std::uint32_t closing(std::size_t open) const { return matching[open]; }
+
+	// Posizioni (crescenti) dei token che seguono un ';' o una '}' del
+	// blocco piu' esterno e iniziano uno statement: dopo la fine di uno
+	// statement solo else (di un if) e il while di un do ancora aperto
+	// possono proseguirlo. Per i programmi corretti le posizioni sono
+	// esatte; il primo statement del blocco non compare.
+	const std::vector<std::uint32_t>& getStatementStarts() const { return statementStarts; }
+
+private:
+	std::vector<std::uint32_t> matching;
+	std::vector<std::uint32_t> statementStarts;
+	bool valid = false;
+};
+
+#endif
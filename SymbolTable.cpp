@@ -0,0 +1,78 @@
+#include "SymbolTable.h"
+
+namespace {
+
+	// hash moltiplicativo: gli atomi sono interi consecutivi
+	std::size_t hashAtom(Atom atom) {
+		return static_cast<std::size_t>(atom * 2654435761u);
+	}
+
+}
+
+
+ScopedSymbolTable::ScopedSymbolTable() : keys(64, EMPTY), heads(64, NONE) {}
+
+
+void ScopedSymbolTable::enterScope() {
+	scopes.push_back(static_cast<std::uint32_t>(entries.size()));
+}
+
+
+void ScopedSymbolTable::exitScope() {
+	const std::uint32_t mark = scopes.back();
+	scopes.pop_back();
+	while (entries.size() > mark) {
+		const Entry& entry = entries.back();
+		heads[position(entry.atom)] = entry.shadowed;
+		entries.pop_back();
+	}
+}
+
+
+const ScopedSymbolTable::Symbol* ScopedSymbolTable::lookup(Atom atom) const {
+	const std::size_t i = position(atom);
+	if (keys[i] == EMPTY || heads[i] == NONE)
+		return nullptr;
+	return &entries[heads[i]].symbol;
+}
+
+
+void ScopedSymbolTable::declare(Atom atom, Symbol symbol) {
+	std::size_t i = position(atom);
+	if (keys[i] == EMPTY) {
+		// al massimo meta' delle posizioni occupate
+		if ((used + 1) * 2 > keys.size()) {
+			grow();
+			i = position(atom);
+		}
+		keys[i] = atom;
+		++used;
+	}
+	entries.push_back(Entry{ symbol, atom, heads[i] });
+	heads[i] = static_cast<std::uint32_t>(entries.size() - 1);
+}
+
+
+// Posizione di atom, o la posizione libera in cui andrebbe inserito
+std::size_t ScopedSymbolTable::position(Atom atom) const {
+	const std::size_t mask = keys.size() - 1;
+	std::size_t i = hashAtom(atom) & mask;
+	while (keys[i] != EMPTY && keys[i] != atom)
+		i = (i + 1) & mask;
+	return i;
+}
+
+
+void ScopedSymbolTable::grow() {
+	std::vector<Atom> oldKeys = std::move(keys);
+	std::vector<std::uint32_t> oldHeads = std::move(heads);
+	keys.assign(oldKeys.size() * 2, EMPTY);
+	heads.assign(oldHeads.size() * 2, NONE);
+	for (std::size_t j = 0; j < oldKeys.size(); ++j) {
+		if (oldKeys[j] == EMPTY)
+			continue;
+		const std::size_t i = position(oldKeys[j]);
+		keys[i] = oldKeys[j];
+		heads[i] = oldHeads[j];
+	}
+}
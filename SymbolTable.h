@@ -0,0 +1,64 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Atoms.h"
+
+class Decl;
+
+// Tabella dei simboli a scope annidati. La ricerca usa l'indirizzamento
+// aperto con scansione lineare: ogni atomo dichiarato ha una posizione che
+// indica la sua dichiarazione visibile. Le dichiarazioni stanno in un'unica
+// pila e ciascuna ricorda quella che nasconde, che torna visibile quando si
+// esce dallo scope; le posizioni non vengono mai liberate, quindi non
+// servono marcatori di cancellazione.
+class ScopedSymbolTable {
+
+public:
+	struct Symbol {
+		Decl* decl;
+		std::uint32_t slot;
+		std::uint32_t depth;
+	};
+
+	ScopedSymbolTable();
+
+	void enterScope();
+	void exitScope();
+	std::uint32_t depth() const { return static_cast<std::uint32_t>(scopes.size()); }
+
+	// Dichiarazione visibile di atom, nullptr se non ce n'e'
+	const Symbol* lookup(Atom atom) const;
+
+	// Dichiara atom nello scope corrente, nascondendo le dichiarazioni
+	// degli scope esterni
+	void declare(Atom atom, Symbol symbol);
+
+private:
+	static constexpr Atom EMPTY = UINT32_MAX;
+	static constexpr std::uint32_t NONE = UINT32_MAX;
+
+	struct Entry {
+		Symbol symbol;
+		Atom atom;
+		std::uint32_t shadowed;
+	};
+
+	std::size_t position(Atom atom) const;
+	void grow();
+
+	// keys[i] e' l'atomo della posizione i (EMPTY se libera), heads[i]
+	// l'indice in entries della sua dichiarazione visibile (NONE se nessuna)
+	std::vector<Atom> keys;
+	std::vector<std::uint32_t> heads;
+	std::size_t used = 0;
+
+	std::vector<Entry> entries;
+	// per ogni scope aperto, quante dichiarazioni c'erano alla sua apertura
+	std::vector<std::uint32_t> scopes;
+};
+
+#endif
@@ -1,7 +1,8 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <string>
+#include <cstdint>
+#include <ostream>
 
 // I token della grammatica delle espressioni numeriche sono:
 // - Parentesi aperte e chiuse
@@ -43,6 +44,12 @@ struct Token {
     static constexpr int ASSIGN = 19;
     static constexpr int END_STMT = 20;
 
+	//i simboli terminali con parola fissa (parentesi e operatori) hanno tag
+	//in [FIRST_SYMBOL, LAST_SYMBOL]: le tabelle del lexer (LexerTables.h)
+	//vengono generate da questo intervallo di id2word
+	static constexpr int FIRST_SYMBOL = LP;
+	static constexpr int LAST_SYMBOL = END_STMT;
+
 	//simboli terminali definiti con regex
 	static constexpr int NUM = 21;
 	static constexpr int ID = 22;
@@ -60,23 +67,41 @@ struct Token {
 	static constexpr int FALSE = 31;
 	static constexpr int PRINT = 32;
 
-	// si rende id2word non constexpr, in questo modo può essere indicizzata anche con indici non costanti 
-	static const char* id2word[];
+	//terminatore dello stream di token
+	static constexpr int END_OF_INPUT = 33;
+
+	// id2word e' constexpr (e quindi, dal C++17, implicitamente inline): puo' essere
+	// indicizzata con indici non costanti e allo stesso tempo letta a tempo di
+	// compilazione per generare le tabelle del lexer (vedi Keywords.h)
+	static constexpr const char* id2word[]{
+		"(", ")","{","}","[","]","+", "-", "*", "/", "||", "&&", "==", "!=", "<", "<=", ">", ">=", "!", "=", ";", "NUM", "ID", "if", "else", "do",
+		"while", "break", "int", "boolean", "true", "false","print", "EOF"
+	};
 	
 	//keywords_id contiene gli id numerici dei token keyword 
-	static const int keywordsId[];
+	static constexpr int keywordsId[]{ IF, ELSE, DO, WHILE, BREAK, INT, BOOL, TRUE, FALSE, PRINT };
 
-	static const int keywordsIdSize = 10;
+	static constexpr int keywordsIdSize = sizeof(keywordsId) / sizeof(keywordsId[0]);
 
-	Token(int t, const char* w) : tag{ t }, word{ w } { }
-	Token(int t, std::string w) : tag{ t }, word{ w } { }
+	// Il token non possiede la propria parola: ne registra solo la posizione
+	// (offset, length) nel buffer sorgente, cosi' lo stream di token e' un
+	// unico array di elementi piccoli. La parola si ottiene con
+	// TokenStream::spelling quando serve davvero (ID, NUM, messaggi d'errore).
+	Token(int t, std::uint32_t o, std::uint32_t l, std::int32_t v = 0)
+		: tag{ t }, offset{ o }, length{ l }, value{ v } { }
 	~Token() = default;
 	Token(Token const&) = default;
 	Token& operator=(Token const&) = default;
 
-	// La coppia (ID, parola) che costituisce il Token
+	// La coppia (ID, parola) che costituisce il Token, con la parola
+	// espressa come intervallo del sorgente
 	int tag;
-	std::string word;
+	std::uint32_t offset;
+	std::uint32_t length;
+
+	// Valore delle costanti intere (NUM), calcolato durante il lessing, o
+	// atomo del nome degli identificatori (ID, vedi Atoms.h)
+	std::int32_t value;
 };
 
 
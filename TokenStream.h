@@ -0,0 +1,91 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "SourceBuffer.h"
+#include "Token.h"
+
+// Finestra di token contigui messa a disposizione del Parser
+struct TokenWindow {
+	const Token* first;
+	const Token* last;
+};
+
+// Sorgente da cui il Parser preleva i token. La sorgente puo' avere gia'
+// tutti i token in memoria (TokenStream) oppure produrli su richiesta
+// mentre legge l'input (StreamLexer): il Parser vede in entrambi i casi
+// una finestra che termina, quando l'input e' finito, con END_OF_INPUT.
+class TokenSource {
+
+public:
+	virtual ~TokenSource() = default;
+
+	// Parola del token, che deve appartenere alla finestra corrente
+	virtual std::string_view spelling(const Token& t) const = 0;
+
+	// Restituisce la finestra che inizia in from (nullptr per il primo
+	// token) e contiene almeno lookahead token, oppure arriva fino a
+	// END_OF_INPUT. I token che precedono from possono essere scartati
+	// e i puntatori della finestra precedente non sono piu' validi.
+	virtual TokenWindow fill(const Token* from, std::size_t lookahead) = 0;
+};
+
+// Risultato del lessing: il buffer sorgente e l'array dei token che vi fanno
+// riferimento. I token sono validi finche' e' vivo il TokenStream.
+class TokenStream : public TokenSource {
+
+public:
+	// Stream vuoto, senza sorgente
+	TokenStream() : TokenStream{ SourceBuffer::fromMemory({}) } { }
+	explicit TokenStream(SourceBuffer src) : source{ std::move(src) } { }
+	~TokenStream() = default;
+	TokenStream(TokenStream const&) = delete;
+	TokenStream& operator=(TokenStream const&) = delete;
+	TokenStream(TokenStream&&) = default;
+	TokenStream& operator=(TokenStream&&) = default;
+
+	// Parola corrispondente al token, letta dal buffer sorgente
+	std::string_view spelling(const Token& t) const override {
+		return std::string_view{ source.data() + t.offset, t.length };
+	}
+
+	// Tutti i token sono gia' disponibili: la finestra e' l'intero stream
+	TokenWindow fill(const Token* from, std::size_t) override {
+		return TokenWindow{ from ? from : tokens.data(), tokens.data() + tokens.size() };
+	}
+
+	// Aggiunge il terminatore END_OF_INPUT, che non compare fra i token
+	// restituiti da begin()/end()
+	void close() {
+		tokens.push_back(Token{ Token::END_OF_INPUT,
+			static_cast<std::uint32_t>(source.size()), 0 });
+		closed = true;
+	}
+
+	const SourceBuffer& getSource() const { return source; }
+
+	// Sostituisce il buffer sorgente e restituisce il precedente; i token
+	// vanno aggiornati dal chiamante (vedi IncrementalParser)
+	SourceBuffer exchangeSource(SourceBuffer src) {
+		std::swap(source, src);
+		return src;
+	}
+
+	std::vector<Token>& getTokens() { return tokens; }
+	const std::vector<Token>& getTokens() const { return tokens; }
+
+	std::vector<Token>::const_iterator begin() const { return tokens.begin(); }
+	std::vector<Token>::const_iterator end() const { return tokens.end() - (closed ? 1 : 0); }
+	std::size_t size() const { return tokens.size() - (closed ? 1 : 0); }
+
+private:
+	SourceBuffer source;
+	std::vector<Token> tokens;
+	bool closed = false;
+};
+
+#endif
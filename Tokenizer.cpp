@@ -1,182 +1,208 @@
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <exception>
 #include <string>
 #include <sstream>
+#include <thread>
 
 #include "Tokenizer.h"
+#include "Atoms.h"
+#include "Keywords.h"
+#include "LexerTables.h"
+#include "ScanKernels.h"
+#include "SourceBuffer.h"
 #include "Exceptions.h"
 
-bool Tokenizer::isKeyword(std::string word, int& token_id)
+bool Tokenizer::isKeyword(std::string_view word, int& token_id)
 {
-
-    for(int i = 0; i<Token::keywordsIdSize; i++)
-    {
-        int keyword_id  = Token::keywordsId[i];
-        if(std::string(Token::id2word[keyword_id]) == word)
-        {
-            token_id = keyword_id;
-            return true;
-        }
-    }
-  return false;
+    // hash perfetto generato a tempo di compilazione, vedi Keywords.h
+    int keyword_id = Keywords::lookup(word);
+    if(keyword_id < 0)
+        return false;
+    token_id = keyword_id;
+    return true;
 }
 
 
 
-void Tokenizer::tokenizeInputFile(std::ifstream& inputFile,
-	std::vector<Token>& inputTokens) {
+TokenStream Tokenizer::operator()(std::ifstream& inputFile) {
+	std::ostringstream content;
+	content << inputFile.rdbuf();
+	return tokenize(SourceBuffer::fromMemory(content.str()));
+}
 
-	// Leggo il file carattere per carattere
-	char ch;
-	ch = inputFile.get();
 
-	while (!inputFile.eof()) {
-		if (std::isspace(ch)) {
-			// Salto lo "spazio bianco"
-			ch = inputFile.get();
-			continue;
-		}
-		if (ch == '(') {
-			inputTokens.push_back(Token{ Token::LP, Token::id2word[Token::LP] });
-		}
-		else if (ch == ')') {
-			inputTokens.push_back(Token{ Token::RP, Token::id2word[Token::RP] });
-		}
-		else if (ch == '{') {
-			inputTokens.push_back(Token{ Token::LEFT_CURLY, Token::id2word[Token::LEFT_CURLY] });
-		}
-		else if (ch == '}') {
-			inputTokens.push_back(Token{ Token::RIGHT_CURLY, Token::id2word[Token::RIGHT_CURLY] });
-		}
-		else if (ch == '[') {
-			inputTokens.push_back(Token{ Token::LEFT_SQUARE, Token::id2word[Token::LEFT_SQUARE] });
-		}
-		else if (ch == ']') {
-			inputTokens.push_back(Token{ Token::RIGHT_SQUARE, Token::id2word[Token::RIGHT_SQUARE] });
-		}
-		else if (ch == '+') {
-			inputTokens.push_back(Token{ Token::ADD, Token::id2word[Token::ADD] });
-		}
-		else if (ch == '-') {
-			inputTokens.push_back(Token{ Token::MIN, Token::id2word[Token::MIN] });
-		}
-		else if (ch == '*') {
-			inputTokens.push_back(Token{ Token::MUL, Token::id2word[Token::MUL] });
-		}
-		else if (ch == '/') {
-			inputTokens.push_back(Token{ Token::DIV, Token::id2word[Token::DIV] });
-		}
-		//ADDED
-
-		else if (ch == '|') {
-            ch = inputFile.get();
-			if(ch == '|')
-                inputTokens.push_back(Token{ Token::OR, Token::id2word[Token::OR] });
-            else
-                throw LexicalError("Errore lessicale sul simbolo: |");
-		}
+void Tokenizer::checkSourceSize(std::size_t size) {
+	if (size > UINT32_MAX)
+		throw LexicalError("Sorgente troppo grande: " + std::to_string(size)
+			+ " byte (al massimo " + std::to_string(UINT32_MAX) + ", oltre si puo' usare --stream)");
+}
 
-		else if (ch == '&') {
-            ch = inputFile.get();
-			if(ch == '&')
-                inputTokens.push_back(Token{ Token::AND, Token::id2word[Token::AND] });
-            else
-                throw LexicalError("Errore lessicale sul simbolo: &");
-		}
 
-		else if (ch == '!') {
-			ch = inputFile.peek();
-			if(ch == '=')
-            {
-				inputTokens.push_back(Token{ Token::NOT_EQ, Token::id2word[Token::NOT_EQ] });
-				inputFile.get(); //si toglie dallo stream '='
-			}
-			else
-                inputTokens.push_back(Token{ Token::NOT, Token::id2word[Token::NOT] });
-		}
+TokenStream Tokenizer::tokenize(SourceBuffer source) {
+	checkSourceSize(source.size());
+	TokenStream stream{ std::move(source) };
+	const SourceBuffer& text = stream.getSource();
+	if (threads > 1 && text.size() >= minParallelBytes)
+		tokenizeParallel(text.begin(), text.end(), stream.getTokens());
+	else
+		tokenizeBuffer(text.begin(), text.end(), text.begin(), stream.getTokens());
+	// gli atomi degli identificatori si assegnano dopo la scansione (anche
+	// parallela), in un'unica passata sulla tabella globale
+	std::vector<Token>& tokens = stream.getTokens();
+	AtomTable::global().internIds(tokens.data(), tokens.data() + tokens.size(), text.begin());
+	stream.close();
+	return stream;
+}
 
-		else if (ch == '<') {
-			ch = inputFile.peek();
-			if(ch == '=')
-			{
-				inputTokens.push_back(Token{ Token::LESS_EQ, Token::id2word[Token::LESS_EQ] });
-				inputFile.get(); //si toglie dallo stream '='
-			}
-			else
-                inputTokens.push_back(Token{ Token::LESS, Token::id2word[Token::LESS] });
-		}
 
-		else if (ch == '>') {
-			ch = inputFile.peek();
-			if(ch == '=')
-            {
-				inputTokens.push_back(Token{ Token::MORE_EQ, Token::id2word[Token::MORE_EQ] });
-				inputFile.get(); //si toglie dallo stream '='
-			}    
-            else
-                inputTokens.push_back(Token{ Token::MORE, Token::id2word[Token::MORE] });
-		}
+// La scansione avviene su un intervallo contiguo di byte e ogni token
+// registra soltanto la propria posizione nel buffer: nessuna
+// stringa viene allocata durante il lessing
+void Tokenizer::tokenizeBuffer(const char* begin, const char* end,
+	const char* base, std::vector<Token>& inputTokens) {
 
-		else if (ch == '=') {
-			ch = inputFile.peek();
-			if(ch == '=')
-            {
-				inputTokens.push_back(Token{ Token::EQ, Token::id2word[Token::EQ] });
-				inputFile.get(); //si toglie dallo stream '='
-			}
-			else
-                inputTokens.push_back(Token{ Token::ASSIGN, Token::id2word[Token::ASSIGN] });
-		}
+	// Un token occupa almeno un byte e di norma e' seguito da spazi:
+	// con questa stima il vettore viene allocato una volta sola
+	// (al piu' una seconda per sorgenti molto compatti)
+	inputTokens.reserve(inputTokens.size() + (end - begin) / 3 + 2);
 
-		else if (ch == ';') {
-			inputTokens.push_back(Token{ Token::END_STMT, Token::id2word[Token::END_STMT] });
-		}
+	const char* p = skipWhitespace(begin, end);
+	while (p < end) {
+		Token token{ Token::END_OF_INPUT, 0, 0 };
+		p = skipWhitespace(scanToken(p, end, base, token), end);
+		inputTokens.push_back(token);
+	}
+}
 
-		
-		else if (std::isalpha(ch)){
 
-            //ricostruisco l'intera stringa di caratteri
-            std::stringstream word{};
-			word << ch;
-            while(std::isalnum(ch))
-            {
-                ch = inputFile.peek();
+// Il linguaggio non ha stringhe ne' commenti, quindi ogni spazio bianco
+// separa due token: il buffer viene diviso in blocchi di circa la stessa
+// dimensione, spostando ogni confine in avanti fino al primo spazio.
+// Ogni thread lessa il proprio blocco (con offset relativi all'inizio del
+// buffer) e i risultati vengono concatenati nell'ordine del sorgente.
+// In caso di errori si rilancia quello del primo blocco che ne ha avuto uno,
+// cioe' proprio l'errore che avrebbe trovato il lessing seriale.
+void Tokenizer::tokenizeParallel(const char* begin, const char* end,
+	std::vector<Token>& inputTokens) {
 
-                if(!std::isalnum(ch))
-					break;
+	std::vector<const char*> bounds{ begin };
+	std::size_t chunk = (end - begin) / threads;
+	for (unsigned i = 1; i < threads; ++i) {
+		const char* cut = std::max(bounds.back(), begin + i * chunk);
+		while (cut < end && LexerTables::classOf(*cut) != LexerTables::SPACE)
+			++cut;
+		if (cut < end && cut > bounds.back())
+			bounds.push_back(cut);
+	}
+	bounds.push_back(end);
+
+	std::size_t chunks = bounds.size() - 1;
+	std::vector<std::vector<Token>> partial(chunks);
+	std::vector<std::exception_ptr> errors(chunks);
+	std::vector<std::thread> workers;
+	workers.reserve(chunks - 1);
+
+	auto lexChunk = [&](std::size_t i) {
+		try {
+			tokenizeBuffer(bounds[i], bounds[i + 1], begin, partial[i]);
+		}
+		catch (...) {
+			errors[i] = std::current_exception();
+		}
+	};
+	for (std::size_t i = 1; i < chunks; ++i)
+		workers.emplace_back(lexChunk, i);
+	lexChunk(0);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	for (const std::exception_ptr& error : errors)
+		if (error)
+			std::rethrow_exception(error);
+
+	std::size_t total = inputTokens.size();
+	for (const std::vector<Token>& tokens : partial)
+		total += tokens.size();
+	// spazio anche per il terminatore aggiunto da TokenStream::close
+	inputTokens.reserve(total + 1);
+	for (const std::vector<Token>& tokens : partial)
+		inputTokens.insert(inputTokens.end(), tokens.begin(), tokens.end());
+}
 
-                word << ch;
-				inputFile.get();
-            }
 
-            //id rispettivo al token eventualmente individuato
-             int token_id = 0;
+const char* Tokenizer::skipWhitespace(const char* p, const char* end) {
+	// Salto lo "spazio bianco" (a blocchi di 16/32 byte dove possibile)
+	return ScanKernels::skipWhitespace(p, end);
+}
 
-            if(isKeyword(word.str(), token_id))
-            {
-            	inputTokens.push_back(Token{ token_id, Token::id2word[token_id] });
+
+// Il primo carattere sceglie, con un solo accesso a LexerTables, il ramo
+// del lexer; gli operatori sono riconosciuti dall'automa generato dalle
+// parole dei simboli, preferendo il simbolo piu' lungo (<= rispetto a <)
+const char* Tokenizer::scanToken(const char* p, const char* end,
+	const char* base, Token& token) {
+
+	const char* start = p;
+	token.offset = static_cast<std::uint32_t>(start - base);
+
+	switch (LexerTables::classOf(*p)) {
+	case LexerTables::SYMBOL: {
+		// il primo carattere ha sempre una transizione dallo stato iniziale;
+		// si prosegue solo dagli stati che sono prefisso di simboli piu' lunghi
+		std::uint8_t state = LexerTables::step(0, *p++);
+		std::uint8_t accepted = LexerTables::tables.accept[state];
+		const char* acceptedEnd = p;
+		while (LexerTables::tables.extends[state] && p < end) {
+			state = LexerTables::step(state, *p);
+			if (state == LexerTables::NONE)
+				break;
+			++p;
+			if (LexerTables::tables.accept[state] != LexerTables::NONE) {
+				accepted = LexerTables::tables.accept[state];
+				acceptedEnd = p;
 			}
-            else
-                inputTokens.push_back(Token{ Token::ID, word.str() });
-
-        }
-
-
-		else if (std::isdigit(ch)) {
-			// Costante intera
-			std::stringstream tmp{};
-			tmp << ch;
-			do {
-				ch = inputFile.get();
-				if (std::isdigit(ch)) tmp << ch;
-			} while (std::isdigit(ch));
-			inputTokens.push_back(Token{ Token::NUM, tmp.str() });
-			continue;
 		}
-		else {
-			// Simbolo non riconosciuto
-			std::stringstream tmp{};
-			tmp << "Errore lessicale sul simbolo: " << ch;
-			throw LexicalError(tmp.str());
+		// prefisso di un simbolo che non forma alcun simbolo (es. | isolato)
+		if (accepted == LexerTables::NONE)
+			break;
+		token.tag = accepted;
+		token.length = static_cast<std::uint32_t>(acceptedEnd - start);
+		return acceptedEnd;
+	}
+
+	case LexerTables::ALPHA: {
+		// la parola e' l'intera sequenza alfanumerica
+		p = ScanKernels::skipAlnum(p + 1, end);
+		std::string_view word(start, p - start);
+
+		//id rispettivo al token eventualmente individuato
+		int token_id = 0;
+		token.tag = isKeyword(word, token_id) ? token_id : Token::ID;
+		token.length = static_cast<std::uint32_t>(p - start);
+		return p;
+	}
+
+	case LexerTables::DIGIT: {
+		// Costante intera: il valore viene convertito qui, una volta sola
+		p = ScanKernels::skipDigits(p + 1, end);
+		std::from_chars_result result = std::from_chars(start, p, token.value);
+		if (result.ec == std::errc::result_out_of_range) {
+			throw LexicalError("Costante intera troppo grande: " + std::string(start, p));
 		}
-		ch = inputFile.get();
+		token.tag = Token::NUM;
+		token.length = static_cast<std::uint32_t>(p - start);
+		return p;
+	}
+
+	default:
+		break;
 	}
-}
\ No newline at end of file
+
+	// Simbolo non riconosciuto
+	std::stringstream tmp{};
+	tmp << "Errore lessicale sul simbolo: " << *start;
+	throw LexicalError(tmp.str());
+}
@@ -1,31 +1,75 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
+#include <cstddef>
 #include <vector>
 #include <fstream>
+#include <string>
+#include <string_view>
 
 #include "Token.h"
+#include "TokenStream.h"
 
 class Tokenizer {
 
 public:
 	Tokenizer() = default;
+	// Con numThreads > 1 i sorgenti grandi vengono divisi in blocchi lessati
+	// in parallelo; il risultato e' identico a quello del lessing seriale
+	explicit Tokenizer(unsigned numThreads) : threads{ numThreads > 0 ? numThreads : 1 } { }
 	~Tokenizer() = default;
 	Tokenizer(Token const&) = delete;
 	Token& operator=(Token const&) = delete;
 
-	std::vector<Token> operator()(std::ifstream& inputFile) {
-		std::vector<Token> inputTokens;
-		tokenizeInputFile(inputFile, inputTokens);
-		return inputTokens;
+	// Lo stream viene letto per intero in memoria e poi scandito come buffer
+	TokenStream operator()(std::ifstream& inputFile);
+
+	// Lessing dell'intero file visto come intervallo contiguo di byte
+	// (mappato in memoria quando possibile, vedi SourceBuffer)
+	TokenStream operator()(const std::string& path) {
+		return tokenize(SourceBuffer{ path });
+	}
+
+	// Lessing di un buffer gia' presente in memoria (non viene copiato:
+	// deve sopravvivere al TokenStream restituito)
+	TokenStream operator()(const char* data, std::size_t size) {
+		return tokenize(SourceBuffer::borrow(data, size));
 	}
 
+	// Lessing di un buffer di cui il TokenStream restituito prende possesso
+	TokenStream operator()(SourceBuffer source) {
+		return tokenize(std::move(source));
+	}
+
+	// Salta lo spazio bianco a partire da p, restituendo il primo carattere utile
+	static const char* skipWhitespace(const char* p, const char* end);
+
+	// Riconosce il token che inizia in p (carattere non bianco, p < end),
+	// con offset relativo a base; restituisce la posizione successiva al token.
+	// Un token che termina esattamente in end potrebbe proseguire oltre:
+	// chi legge a blocchi (StreamLexer) deve rileggerlo con piu' testo.
+	static const char* scanToken(const char* p, const char* end, const char* base, Token& token);
+
+	// Gli offset dei token sono a 32 bit: un sorgente lessato per intero
+	// (non a stream) non puo' superare UINT32_MAX byte. Lancia LexicalError
+	static void checkSourceSize(std::size_t size);
+
 private:
-    bool isKeyword(std::string stream,  int& token_id);
+    static bool isKeyword(std::string_view word,  int& token_id);
+
+	// sotto questa dimensione il lessing parallelo non conviene
+	static constexpr std::size_t minParallelBytes = 1 << 20;
+
+	TokenStream tokenize(SourceBuffer source);
 
-	void tokenizeInputFile(std::ifstream& inputFile, std::vector<Token>& inputTokens);
+	// gli offset dei token sono relativi a base
+	void tokenizeBuffer(const char* begin, const char* end, const char* base,
+		std::vector<Token>& inputTokens);
+
+	void tokenizeParallel(const char* begin, const char* end, std::vector<Token>& inputTokens);
+
+	unsigned threads = 1;
 
 };
 
 #endif
-
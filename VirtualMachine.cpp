@@ -0,0 +1,220 @@
+#include "VirtualMachine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "EvaluationVisitor.h"
+#include "Exceptions.h"
+
+#if defined(__GNUC__)
+// Con GCC e Clang ogni istruzione salta direttamente alla successiva
+// (computed goto) invece di tornare a un unico switch: il salto indiretto
+// e' diverso per ogni istruzione e viene previsto meglio
+#define VM_THREADED_DISPATCH 1
+#else
+#define VM_THREADED_DISPATCH 0
+#endif
+
+namespace {
+
+	// aritmetica modulo 2^32, come in EvaluationVisitor
+	int wrap(std::uint32_t v) {
+		return static_cast<int>(v);
+	}
+
+	std::uint32_t bits(int v) {
+		return static_cast<std::uint32_t>(v);
+	}
+
+}
+
+
+void VirtualMachine::run(const BytecodeView& bytecode) {
+	frame.assign(bytecode.frameSize, Cell{ 0, false });
+	stack.assign(bytecode.stackSize + 1, 0);
+
+	const Instruction* const code = bytecode.code;
+	const Instruction* pc = code;
+	Cell* const cells = frame.data();
+	// prima posizione libera della pila
+	int* sp = stack.data();
+
+	const Instruction* instruction;
+
+#if VM_THREADED_DISPATCH
+	static void* const labels[] = {
+		&&L_PUSH, &&L_LOAD, &&L_STORE, &&L_LOAD_ELEM, &&L_CHECK_INDEX, &&L_STORE_ELEM, &&L_CLEAR,
+		&&L_ADD, &&L_SUB, &&L_MUL, &&L_DIV,
+		&&L_EQ, &&L_NOT_EQ, &&L_MORE, &&L_MORE_EQ, &&L_LESS, &&L_LESS_EQ,
+		&&L_NEG, &&L_NOT,
+		&&L_JUMP, &&L_JUMP_IF_FALSE, &&L_JUMP_IF_TRUE, &&L_JUMP_IF_FALSE_OR_POP, &&L_JUMP_IF_TRUE_OR_POP,
+		&&L_PRINT_INT, &&L_PRINT_BOOL, &&L_ERROR, &&L_HALT
+	};
+	static_assert(sizeof(labels) / sizeof(labels[0]) == static_cast<std::size_t>(OpCode::HALT) + 1,
+		"una destinazione per ogni OpCode, nello stesso ordine");
+#define INSTRUCTION(name) L_##name:
+#define NEXT do { instruction = pc++; goto *labels[static_cast<int>(instruction->op)]; } while (false)
+	NEXT;
+	{
+#else
+#define INSTRUCTION(name) case OpCode::name:
+#define NEXT break
+	for (;;) {
+		instruction = pc++;
+		switch (instruction->op) {
+#endif
+		INSTRUCTION(PUSH)
+			*sp++ = instruction->arg;
+			NEXT;
+
+		INSTRUCTION(LOAD)
+		{
+			const Cell& cell = cells[instruction->arg];
+			if (!cell.defined)
+				throw EvaluationVisitor::unassigned(bytecode.name(bytecode.variables[instruction->aux]));
+			*sp++ = cell.value;
+			NEXT;
+		}
+
+		INSTRUCTION(STORE)
+			cells[instruction->arg] = Cell{ *--sp, true };
+			NEXT;
+
+		INSTRUCTION(LOAD_ELEM)
+		INSTRUCTION(CHECK_INDEX)
+		{
+			const int index = sp[-1];
+			const Bytecode::Variable& vector = bytecode.variables[instruction->aux];
+			if (bits(index) >= bits(vector.size))
+				throw EvaluationVisitor::outOfBounds(index, bytecode.name(vector), vector.size);
+			if (instruction->op == OpCode::CHECK_INDEX)
+				NEXT;
+			const Cell& cell = cells[instruction->arg + index];
+			if (!cell.defined)
+				throw EvaluationVisitor::unassignedElement(bytecode.name(vector));
+			sp[-1] = cell.value;
+			NEXT;
+		}
+
+		INSTRUCTION(STORE_ELEM)
+			sp -= 2;
+			cells[instruction->arg + sp[0]] = Cell{ sp[1], true };
+			NEXT;
+
+		INSTRUCTION(CLEAR)
+			for (Cell* cell = cells + instruction->arg, *last = cell + instruction->aux; cell != last; ++cell)
+				cell->defined = false;
+			NEXT;
+
+		INSTRUCTION(ADD)
+			--sp;
+			sp[-1] = wrap(bits(sp[-1]) + bits(sp[0]));
+			NEXT;
+
+		INSTRUCTION(SUB)
+			--sp;
+			sp[-1] = wrap(bits(sp[-1]) - bits(sp[0]));
+			NEXT;
+
+		INSTRUCTION(MUL)
+			--sp;
+			sp[-1] = wrap(bits(sp[-1]) * bits(sp[0]));
+			NEXT;
+
+		INSTRUCTION(DIV)
+			// divisione per zero e overflow con la semantica dell'interprete
+			--sp;
+			if (sp[0] == 0 || sp[0] == -1)
+				sp[-1] = EvaluationVisitor::arithm(Op::DIV, Value::ofInt(sp[-1]), Value::ofInt(sp[0])).value;
+			else
+				sp[-1] /= sp[0];
+			NEXT;
+
+		INSTRUCTION(EQ)
+			--sp;
+			sp[-1] = sp[-1] == sp[0];
+			NEXT;
+
+		INSTRUCTION(NOT_EQ)
+			--sp;
+			sp[-1] = sp[-1] != sp[0];
+			NEXT;
+
+		INSTRUCTION(MORE)
+			--sp;
+			sp[-1] = sp[-1] > sp[0];
+			NEXT;
+
+		INSTRUCTION(MORE_EQ)
+			--sp;
+			sp[-1] = sp[-1] >= sp[0];
+			NEXT;
+
+		INSTRUCTION(LESS)
+			--sp;
+			sp[-1] = sp[-1] < sp[0];
+			NEXT;
+
+		INSTRUCTION(LESS_EQ)
+			--sp;
+			sp[-1] = sp[-1] <= sp[0];
+			NEXT;
+
+		INSTRUCTION(NEG)
+			sp[-1] = wrap(0u - bits(sp[-1]));
+			NEXT;
+
+		INSTRUCTION(NOT)
+			sp[-1] = !sp[-1];
+			NEXT;
+
+		INSTRUCTION(JUMP)
+			pc = code + instruction->arg;
+			NEXT;
+
+		INSTRUCTION(JUMP_IF_FALSE)
+			if (!*--sp)
+				pc = code + instruction->arg;
+			NEXT;
+
+		INSTRUCTION(JUMP_IF_TRUE)
+			if (*--sp)
+				pc = code + instruction->arg;
+			NEXT;
+
+		INSTRUCTION(JUMP_IF_FALSE_OR_POP)
+			if (!sp[-1])
+				pc = code + instruction->arg;
+			else
+				--sp;
+			NEXT;
+
+		INSTRUCTION(JUMP_IF_TRUE_OR_POP)
+			if (sp[-1])
+				pc = code + instruction->arg;
+			else
+				--sp;
+			NEXT;
+
+		INSTRUCTION(PRINT_INT)
+			out.writeInt(*--sp);
+			NEXT;
+
+		INSTRUCTION(PRINT_BOOL)
+			out.writeBool(*--sp != 0);
+			NEXT;
+
+		INSTRUCTION(ERROR)
+			throw EvaluationError{ std::string{ bytecode.message(instruction->arg) } };
+
+		INSTRUCTION(HALT)
+			out.flush();
+			return;
+#if !VM_THREADED_DISPATCH
+		}
+#endif
+	}
+#undef INSTRUCTION
+#undef NEXT
+}
@@ -0,0 +1,35 @@
+#ifndef VIRTUAL_MACHINE_H
+#define VIRTUAL_MACHINE_H
+
+#include <iostream>
+#include <vector>
+
+#include "BufferedWriter.h"
+#include "Bytecode.h"
+
+// Esecuzione del Bytecode prodotto da BytecodeCompiler, con una pila
+// esplicita degli operandi e lo stesso frame di celle di EvaluationVisitor.
+// Gli errori di esecuzione sono EvaluationError con gli stessi messaggi, e
+// le stampe gia' eseguite escono comunque.
+class VirtualMachine {
+
+public:
+	explicit VirtualMachine(std::ostream& os = std::cout) : out{ os } {}
+	VirtualMachine(VirtualMachine const&) = delete;
+	VirtualMachine& operator=(VirtualMachine const&) = delete;
+
+	// Esegue il programma dall'inizio, con tutte le variabili non assegnate
+	void run(const BytecodeView& bytecode);
+
+private:
+	struct Cell {
+		int value;
+		bool defined;
+	};
+
+	BufferedWriter out;
+	std::vector<Cell> frame;
+	std::vector<int> stack;
+};
+
+#endif
@@ -55,274 +55,380 @@ public:
     virtual void visitRel(Rel* relNode) = 0;
 };
 
-// Visitor concreto per la valutazione delle espressioni
-class EvaluationVisitor : public Visitor {
+// Visitor statico (CRTP): visit sceglie con uno switch sul tipo del nodo il
+// metodo visitXxx di Derived e lo chiama direttamente, senza funzioni
+// virtuali, cosi' il compilatore puo' espandere inline l'intera visita.
+// I metodi che Derived non ridefinisce visitano i figli con Derived::visit
+// (che Derived puo' a sua volta ridefinire, per esempio per contare i nodi),
+// scartandone i risultati, e restituiscono Result().
+template <typename Derived, typename Result = void>
+class StaticVisitor {
 public:
-    EvaluationVisitor() : intAccumulator{ }, boolAccumulator{} { }
-    ~EvaluationVisitor() = default;
-    EvaluationVisitor(EvaluationVisitor const&) = delete;
-    EvaluationVisitor& operator=(EvaluationVisitor const&) = delete;
-
-    /*void visitOperator(Operator* opNode) override {
-        // Prelevo i puntatori agli operandi e gli faccio accettare 
-        // questo oggetto come visitatore (propago la visita)
-        Expression* left = opNode->getLeft();
-        left->accept(this);
-        Expression* right = opNode->getRight();
-        right->accept(this);
-        // Prelevo i valori dall'accumulatore
-        int rval = accumulator.back(); accumulator.pop_back();
-        int lval = accumulator.back(); accumulator.pop_back();
-        switch (opNode->getOp()) {
-        case Operator::PLUS:
-            accumulator.push_back(lval + rval); return;
-        case Operator::MINUS:
-            accumulator.push_back(lval - rval); return;
-        case Operator::TIMES:
-            accumulator.push_back(lval * rval); return;
-        case Operator::DIV:
-            if (rval == 0) {
-                throw EvaluationError{ "Division by zero" };
-            }
-            accumulator.push_back(lval / rval); return;
-        default:
-            return;
+    Result visit(Node* node) {
+        Derived& d = static_cast<Derived&>(*this);
+        switch(node->getKind()) {
+        case NodeKind::PROGRAM: return d.visitProgram(static_cast<Program*>(node));
+        case NodeKind::BLOCK: return d.visitBlock(static_cast<Block*>(node));
+        case NodeKind::TYPE: return d.visitType(static_cast<Type*>(node));
+        case NodeKind::VECTOR_TYPE: return d.visitVectorType(static_cast<vectorType*>(node));
+        case NodeKind::DECLS: return d.visitDecls(static_cast<Decls*>(node));
+        case NodeKind::DECL: return d.visitDecl(static_cast<Decl*>(node));
+        case NodeKind::ID: return d.visitId(static_cast<Id*>(node));
+        case NodeKind::STMTS: return d.visitStmts(static_cast<Stmts*>(node));
+        case NodeKind::INT_CONSTANT: return d.visitIntConstant(static_cast<intConstant*>(node));
+        case NodeKind::BOOL_CONSTANT: return d.visitBoolConstant(static_cast<boolConstant*>(node));
+        case NodeKind::BIN_OP: return d.visitBinOp(static_cast<Arithm*>(node));
+        case NodeKind::UNARY_OP: return d.visitUnaryOp(static_cast<Unary*>(node));
+        case NodeKind::ACCESS: return d.visitAccess(static_cast<Access*>(node));
+        case NodeKind::IF: return d.visitIf(static_cast<If*>(node));
+        case NodeKind::ELSE: return d.visitElse(static_cast<Else*>(node));
+        case NodeKind::WHILE: return d.visitWhile(static_cast<While*>(node));
+        case NodeKind::DO: return d.visitDo(static_cast<Do*>(node));
+        case NodeKind::SET: return d.visitSet(static_cast<Set*>(node));
+        case NodeKind::SET_ELEM: return d.visitSetElem(static_cast<SetElem*>(node));
+        case NodeKind::BREAK: return d.visitBreak(static_cast<Break*>(node));
+        case NodeKind::PRINT: return d.visitPrint(static_cast<Print*>(node));
+        case NodeKind::NOT: return d.visitNot(static_cast<Not*>(node));
+        case NodeKind::AND: return d.visitAnd(static_cast<And*>(node));
+        case NodeKind::OR: return d.visitOr(static_cast<Or*>(node));
+        case NodeKind::REL:
+        default: return d.visitRel(static_cast<Rel*>(node));
         }
     }
-    void visitIntConstant (intConstant* numNode) override {
-         intAccumulator.push_back(numNode->getValue());
-    }
 
-    void visitBoolConstant (boolConstant* numNode) override {
-         boolAccumulator.push_back(numNode->getValue());
+    Result visitProgram(Program* program) { return children(program->getBlock()); }
+    Result visitBlock(Block* block) {
+        if(block->getDecls())
+            children(block->getDecls());
+        if(block->getStmts())
+            children(block->getStmts());
+        return Result();
+    }
+    Result visitType(Type*) { return Result(); }
+    Result visitVectorType(vectorType*) { return Result(); }
+    Result visitDecls(Decls* decls) {
+        for(Decl* decl : *decls)
+            children(decl);
+        return Result();
+    }
+    Result visitDecl(Decl* decl) { return children(decl->getType(), decl->getId()); }
+    Result visitId(Id*) { return Result(); }
+    Result visitStmts(Stmts* stmts) {
+        for(Stmt* stmt : *stmts)
+            children(stmt);
+        return Result();
     }
-    */
-    int getIntValue() const {
-        return intAccumulator.back();
+    Result visitIntConstant(intConstant*) { return Result(); }
+    Result visitBoolConstant(boolConstant*) { return Result(); }
+    Result visitBinOp(Arithm* arithmNode) { return children(arithmNode->getLeftExp(), arithmNode->getRightExp()); }
+    Result visitUnaryOp(Unary* unaryNode) { return children(unaryNode->getExp()); }
+    Result visitAccess(Access* accessNode) { return children(accessNode->getId(), accessNode->getIndex()); }
+    Result visitIf(If* ifNode) { return children(ifNode->getCondition(), ifNode->getStmt()); }
+    Result visitElse(Else* elseNode) {
+        return children(elseNode->getCondition(), elseNode->getifTrueStmt(), elseNode->getifFalseStmt());
     }
-    bool getBoolValue() const {
-        return boolAccumulator.back();
+    Result visitWhile(While* whileNode) { return children(whileNode->getCondition(), whileNode->getStmt()); }
+    Result visitDo(Do* doNode) { return children(doNode->getStmt(), doNode->getCondition()); }
+    Result visitSet(Set* setNode) { return children(setNode->getId(), setNode->getExp()); }
+    Result visitSetElem(SetElem* setElemNode) {
+        return children(setElemNode->getId(), setElemNode->getIndex(), setElemNode->getExp());
     }
+    Result visitBreak(Break*) { return Result(); }
+    Result visitPrint(Print* printNode) { return children(printNode->getExp()); }
+    Result visitNot(Not* notNode) { return children(notNode->getExp()); }
+    Result visitAnd(And* andNode) { return children(andNode->getLeftExp(), andNode->getRightExp()); }
+    Result visitOr(Or* orNode) { return children(orNode->getLeftExp(), orNode->getRightExp()); }
+    Result visitRel(Rel* relNode) { return children(relNode->getLeftExp(), relNode->getRightExp()); }
+
+protected:
+    // visita i nodi nell'ordine dato
+    template <typename... Nodes>
+    Result children(Nodes*... nodes) {
+        Derived& d = static_cast<Derived&>(*this);
+        ((void)d.visit(nodes), ...);
+        return Result();
+    }
+};
+
+// Conta i nodi visitati, per tipo: un nodo condiviso (--share) viene
+// contato una volta per ogni punto in cui compare nel programma
+class NodeCounter : public StaticVisitor<NodeCounter> {
+public:
+    void visit(Node* node) {
+        ++counts[static_cast<std::size_t>(node->getKind())];
+        ++visited;
+        StaticVisitor::visit(node);
+    }
+
+    std::size_t count(NodeKind kind) const { return counts[static_cast<std::size_t>(kind)]; }
+    std::size_t total() const { return visited; }
+
 private:
-    std::vector<int> intAccumulator;
-    std::vector<bool> boolAccumulator;
+    std::size_t counts[numOfNodeKinds] = {};
+    std::size_t visited = 0;
 };
 
 
-// Visitor concreto per la stampa delle espressioni
-class PrintVisitor : public Visitor {
+// Visitor delle espressioni che restituisce il valore di ogni visita invece
+// di accumularlo: visit sceglie con uno switch sul tipo del nodo il metodo
+// da chiamare (una sola chiamata virtuale) e ne restituisce il risultato,
+// che resta nei registri senza passare per una pila sullo heap
+template <typename R>
+class ResultVisitor {
 public:
-    PrintVisitor() = default;
+    virtual ~ResultVisitor() = default;
+
+    R visit(Expression* exp) {
+        switch(exp->getKind()) {
+        case NodeKind::ID: return visitId(static_cast<Id*>(exp));
+        case NodeKind::INT_CONSTANT: return visitIntConstant(static_cast<intConstant*>(exp));
+        case NodeKind::BOOL_CONSTANT: return visitBoolConstant(static_cast<boolConstant*>(exp));
+        case NodeKind::BIN_OP: return visitBinOp(static_cast<Arithm*>(exp));
+        case NodeKind::UNARY_OP: return visitUnaryOp(static_cast<Unary*>(exp));
+        case NodeKind::ACCESS: return visitAccess(static_cast<Access*>(exp));
+        case NodeKind::NOT: return visitNot(static_cast<Not*>(exp));
+        case NodeKind::AND: return visitAnd(static_cast<And*>(exp));
+        case NodeKind::OR: return visitOr(static_cast<Or*>(exp));
+        case NodeKind::REL: return visitRel(static_cast<Rel*>(exp));
+        default:
+            throw EvaluationError("visit of a node that is not an expression");
+        }
+    }
+
+    virtual R visitId(Id* idNode) = 0;
+    virtual R visitIntConstant(intConstant* numNode) = 0;
+    virtual R visitBoolConstant(boolConstant* boolNode) = 0;
+    virtual R visitBinOp(Arithm* arithmNode) = 0;
+    virtual R visitUnaryOp(Unary* unaryNode) = 0;
+    virtual R visitAccess(Access* accessNode) = 0;
+    virtual R visitNot(Not* notNode) = 0;
+    virtual R visitAnd(And* andNode) = 0;
+    virtual R visitOr(Or* orNode) = 0;
+    virtual R visitRel(Rel* relNode) = 0;
+};
+
+
+// Visitor concreto per la stampa delle espressioni. Si usa attraverso
+// Node::accept come ogni Visitor, ma i figli vengono visitati con
+// StaticVisitor::visit, senza chiamate virtuali
+class PrintVisitor final : public Visitor, public StaticVisitor<PrintVisitor> {
+public:
+    // stampa su os (di default lo standard output)
+    explicit PrintVisitor(std::ostream& os = std::cout) : out{ os } { }
     ~PrintVisitor() = default;
     PrintVisitor(PrintVisitor const&) = delete;
     PrintVisitor& operator=(PrintVisitor const&) = delete;
 
     void visitProgram(Program* program) override {
-        std::cout<<"Program(";
-        program->getBlock()->accept(this);
-        std::cout<<")";
+        out<<"Program(";
+        visit(program->getBlock());
+        out<<")";
     }
 
     void visitBlock(Block* block) override {
-        std::cout<<"Block(";
+        out<<"Block(";
         if(block->getDecls()) 
-            block->getDecls()->accept(this);
+            visit(block->getDecls());
         else 
-            std::cout<<"NULL";
-        std::cout<<", ";
+            out<<"NULL";
+        out<<", ";
         if(block->getStmts()) 
-            block->getStmts()->accept(this);
+            visit(block->getStmts());
         else 
-            std::cout<<"NULL";
-        std::cout<<")";
+            out<<"NULL";
+        out<<")";
     }
 
+    // Le liste sono stampate nella forma annidata Decls(d1, Decls(d2, NULL))
     void visitDecls(Decls* decls) override {
 
-        std::cout<<"Decls(";
-        decls->getDecl()->accept(this);
-        std::cout<<", ";
-        if(decls->getDecls())
-            decls->getDecls()->accept(this);
-        else 
-            std::cout<<"NULL";
-        std::cout<<")";
+        for(Decl* decl : *decls) {
+            out<<"Decls(";
+            visit(decl);
+            out<<", ";
+        }
+        out<<"NULL";
+        for(std::size_t i = 0; i < decls->getSize(); i++)
+            out<<")";
     }
 
     void visitDecl(Decl* decl) override {
-        std::cout<<"Decl(";
-        decl->getType()->accept(this);
-        std::cout<<", ";
-        decl->getId()->accept(this);
-        std::cout<<")";
+        out<<"Decl(";
+        visit(decl->getType());
+        out<<", ";
+        visit(decl->getId());
+        out<<")";
     }
 
     void visitType(Type* type) override {
-        std::cout<<"Type(";
-        std::cout<<Type::typeid2String[type->getType()];
-        std::cout<<")";
+        out<<"Type(";
+        out<<Type::typeid2String[type->getType()];
+        out<<")";
     }
 
     void visitVectorType(vectorType* type) override {
-        std::cout<<"VectorType(";
-        std::cout<<Type::typeid2String[type->getType()];
-        std::cout<<", ["<<type->getSize()<<"]";
-        std::cout<<")";
+        out<<"VectorType(";
+        out<<Type::typeid2String[type->getType()];
+        out<<", ["<<type->getSize()<<"]";
+        out<<")";
     }
 
 
     void visitId(Id* id) override {
-        std::cout<<"Id(";
-        std::cout<<id->getName();
-        std::cout<<")";
+        out<<"Id(";
+        out<<id->getName();
+        out<<")";
     }
 
     void visitStmts(Stmts* stmts) override {
 
-        std::cout<<"Stmts(";
-        stmts->getStmt()->accept(this);
-        std::cout<<", ";
-        if(stmts->getStmts())
-            stmts->getStmts()->accept(this);
-        else 
-            std::cout<<"NULL";
-        std::cout<<")";
+        for(Stmt* stmt : *stmts) {
+            out<<"Stmts(";
+            visit(stmt);
+            out<<", ";
+        }
+        out<<"NULL";
+        for(std::size_t i = 0; i < stmts->getSize(); i++)
+            out<<")";
     }    
     
     void visitIf(If* ifNode) override {
-        std::cout<<"If(";
-        ifNode->getCondition()->accept(this);
-        std::cout<<", ";
-        ifNode->getStmt()->accept(this);
-        std::cout<<")";
+        out<<"If(";
+        visit(ifNode->getCondition());
+        out<<", ";
+        visit(ifNode->getStmt());
+        out<<")";
     }
 
 
     void visitElse(Else* elseNode) override {
-        std::cout<<"Else(";
-        elseNode->getCondition()->accept(this);
-        std::cout<<", ";
-        elseNode->getifTrueStmt()->accept(this);
-        std::cout<<", ";
-        elseNode->getifFalseStmt()->accept(this);
-        std::cout<<")";
+        out<<"Else(";
+        visit(elseNode->getCondition());
+        out<<", ";
+        visit(elseNode->getifTrueStmt());
+        out<<", ";
+        visit(elseNode->getifFalseStmt());
+        out<<")";
     }
 
     void visitWhile(While* whileNode) override {
-        std::cout<<"While(";
-        whileNode->getCondition()->accept(this);
-        std::cout<<", ";
-        whileNode->getStmt()->accept(this);
-        std::cout<<")";
+        out<<"While(";
+        visit(whileNode->getCondition());
+        out<<", ";
+        visit(whileNode->getStmt());
+        out<<")";
     }
 
     void visitDo(Do* doNode) override {
-        std::cout<<"Do(";
-        doNode->getCondition()->accept(this);
-        std::cout<<", ";
-        doNode->getStmt()->accept(this);
-        std::cout<<")";
+        out<<"Do(";
+        visit(doNode->getCondition());
+        out<<", ";
+        visit(doNode->getStmt());
+        out<<")";
     }
 
     void visitSet(Set* setNode) override {
-        std::cout<<"Set(";
-        setNode->getId()->accept(this);
-        std::cout<<", ";        
-        setNode->getExp()->accept(this);
-        std::cout<<")";
+        out<<"Set(";
+        visit(setNode->getId());
+        out<<", ";        
+        visit(setNode->getExp());
+        out<<")";
     }
 
     void visitSetElem(SetElem* setElemNode) override {
-        std::cout<<"SetElem(";
-        setElemNode->getId()->accept(this);
-        std::cout<<",[";        
-        setElemNode->getIndex()->accept(this);
-        std::cout<<"], ";
-        setElemNode->getExp()->accept(this);
-        std::cout<<")";        
+        out<<"SetElem(";
+        visit(setElemNode->getId());
+        out<<",[";        
+        visit(setElemNode->getIndex());
+        out<<"], ";
+        visit(setElemNode->getExp());
+        out<<")";        
     }
 
     void visitBreak(Break* breakNode) override {
-        std::cout<<"Break()";
+        out<<"Break()";
     }
 
     void visitPrint(Print* printNode) override {
-        std::cout<<"Print(";
-        printNode->getExp()->accept(this);
-        std::cout<<")";
+        out<<"Print(";
+        visit(printNode->getExp());
+        out<<")";
     }
 
     void visitNot(Not* notNode) override {
-        std::cout<<"Not(";
-        notNode->getExp()->accept(this);
-        std::cout<<")";        
+        out<<"Not(";
+        visit(notNode->getExp());
+        out<<")";        
     }
 
     void visitAnd(And* andNode) override {
-        std::cout<<"And(";
-        andNode->getLeftExp()->accept(this);
-        std::cout<<", ";        
-        andNode->getRightExp()->accept(this);
-        std::cout<<")";        
+        out<<"And(";
+        visit(andNode->getLeftExp());
+        out<<", ";        
+        visit(andNode->getRightExp());
+        out<<")";        
     }
 
     void visitOr(Or* orNode) override {
-        std::cout<<"Or(";
-        orNode->getLeftExp()->accept(this);
-        std::cout<<", ";        
-        orNode->getRightExp()->accept(this);
-        std::cout<<")";        
+        out<<"Or(";
+        visit(orNode->getLeftExp());
+        out<<", ";        
+        visit(orNode->getRightExp());
+        out<<")";        
     }
 
     void visitRel(Rel* relNode) override {
-        std::cout<<"Rel(";
-        std::cout<<Rel::opCode2String[relNode->getOp()];
-        std::cout<<", ";        
-        relNode->getLeftExp()->accept(this);
-        std::cout<<", ";        
-        relNode->getRightExp()->accept(this);
-        std::cout<<")";                
+        out<<"Rel(";
+        out<<Rel::opCode2String[relNode->getOp()];
+        out<<", ";        
+        visit(relNode->getLeftExp());
+        out<<", ";        
+        visit(relNode->getRightExp());
+        out<<")";                
     }
 
-    void visitIntConstant(intConstant* numNode) 
+    void visitIntConstant(intConstant* numNode) override
     {
-        std::cout<<"IntConstant("<<numNode->getValue()<<")";
+        out<<"IntConstant("<<numNode->getValue()<<")";
     }
     
-    void visitBoolConstant(boolConstant* numNode)
+    void visitBoolConstant(boolConstant* numNode) override
     {
-        std::cout<<"BoolConstant("<<numNode->getValue()<<")";
+        out<<"BoolConstant("<<numNode->getValue()<<")";
     } 
     
-    void visitBinOp(Arithm* arithmNode)
+    void visitBinOp(Arithm* arithmNode) override
     {
-        std::cout<<"Arithm(";
-        std::cout<<Op::binOp2String[arithmNode->getOp()];
-        std::cout<<", ";        
-        arithmNode->getLeftExp()->accept(this);
-        std::cout<<", ";        
-        arithmNode->getRightExp()->accept(this);
-        std::cout<<")";                
+        out<<"Arithm(";
+        out<<Op::binOp2String[arithmNode->getOp()];
+        out<<", ";        
+        visit(arithmNode->getLeftExp());
+        out<<", ";        
+        visit(arithmNode->getRightExp());
+        out<<")";                
     }
     
-    void visitUnaryOp(Unary* unaryNode)
+    void visitUnaryOp(Unary* unaryNode) override
     {
-        std::cout<<"Unary(";
-        std::cout<<Op::unaryOp2String[unaryNode->getOp()];
-        std::cout<<", ";        
-        unaryNode->getExp()->accept(this);        
-        std::cout<<")";                
+        out<<"Unary(";
+        out<<Op::unaryOp2String[unaryNode->getOp()];
+        out<<", ";        
+        visit(unaryNode->getExp());        
+        out<<")";                
     }
 
-    void visitAccess(Access* accessNode)
+    void visitAccess(Access* accessNode) override
     {
-        std::cout<<"Access(";
-        accessNode->getId()->accept(this);
-        std::cout<<",[";        
-        accessNode->getIndex()->accept(this);
-        std::cout<<",] )";        
+        out<<"Access(";
+        visit(accessNode->getId());
+        out<<",[";        
+        visit(accessNode->getIndex());
+        out<<",] )";        
     }
 
+
+private:
+    std::ostream& out;
 };
 
 